@@ -1,13 +1,35 @@
-#include "wordle-algorithms.cpp"
+#include "wordle-tree.cpp"
+
+#define SWEEP_URL "opener-sweep.csv"
+#define RESULTS_URL "run-results.csv" // .csv is written as text, any other extension as binary
+#define RESULTS_VERSION 1
+#define REPORT_WORST 10 // Longest games printed with their guesses
+#define REPORT_CHUNK (1 << 16) // Bytes of results a thread buffers before writing them out
+
+struct OpenerResult;
+struct GameRecord;
+struct RunReportHeader;
+struct RunStats;
+struct RunReport;
+uint32_t requireWord(const words &w, const std::string &word);
 
 template <typename Algo>
-void runAlgorithm(const words &w, Algo algorithm, std::string firstGuess);
+void runAlgorithm(const words &w, Algo algorithm, std::string firstGuess, bool hardMode = false);
 template <typename Algo>
-void runAlgorithm(const words &w, Algo algorithm, std::string firstGuess, std::string wrd);
+void runAlgorithm(const words &w, Algo algorithm, std::string firstGuess, std::string wrd, bool hardMode = false);
 template <typename Algo>
 void runAlgorithm_stepthrough(const words &w, Algo algorithm, std::string firstGuess);
 template <typename Algo>
-void playSecretWord(const words &w, Algo algorithm);
+void runAlgorithm_parallel(const words &w, Algo algorithm, std::string firstGuess, int threads, bool hardMode = false);
+template <typename Algo>
+void runAlgorithm_allocations(const words &w, Algo algorithm, std::string firstGuess);
+template <typename Algo>
+std::vector<OpenerResult> sweepOpeners(const words &w, Algo algorithm, const std::vector<std::string> &openers, int threads);
+NormalWeights tuneNormalWeights(const words &w, const std::string &firstGuess, int rounds, int population, uint64_t seed, int threads);
+void runAlgorithm(const words &w, const SolveTree &tree);
+template <typename Algo>
+void playSecretWord(const words &w, Algo algorithm, bool hardMode = false);
+void playSecretWord(const words &w, const SolveTree &tree);
 void playSecretWord(const words &w);
 
 void playWordle(const words &w, std::string word);
@@ -15,55 +37,333 @@ void autoWordle(const words &w, std::string word, const std::vector<std::string>
 void printTurn(const words &w, const WordleGame &game, const std::string &guess);
 void printTurn(const words &w, const WordleGame &game, const std::string &guess, const std::string &recommendation);
 void printResult(const words &w, const WordleGame &game, const std::string &guess);
+void printSweep(const words &w, const std::vector<OpenerResult> &results, size_t top, const std::string &path);
 inline void printMainMenu();
 
+// -------------------------------------------------------------------------------------------------
+//                                         Run Reports
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * One finished game of a dictionary run. Written field by field, see RunReportHeader.
+ */
+struct GameRecord
+{
+    uint32_t answer;                         // Word index
+    uint8_t turns;                           // Turns played, MAX_TURNS when lost
+    uint8_t won;
+    uint64_t ns;                             // Wall time of the whole game
+    std::array<uint32_t, MAX_TURNS> guesses; // Word indices, the first `turns` are played
+};
+
+/**
+ * Binary results layout, followed by one record per game. Native byte order, no padding:
+ *
+ *   offset  size            field
+ *   0       4               answer   word index
+ *   4       1               turns
+ *   5       1               won
+ *   6       2               reserved, 0
+ *   8       8               ns
+ *   16      4 * maxTurns    guesses  word indices, the first `turns` are played
+ *
+ * recordSize is 16 + 4 * maxTurns.
+ */
+struct RunReportHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t wordLen;
+    uint32_t maxTurns;
+    uint32_t recordSize;
+};
+
+/**
+ * Distributions of the games one thread played, and their results file entries
+ * not written yet. Only its thread touches it until it is merged.
+ */
+struct alignas(64) RunStats
+{
+    std::array<int, MAX_TURNS + 1> histogram = {0}; // [k] - won in k turns, [0] - lost
+    uint64_t turns = 0;
+    std::vector<uint64_t> times;
+    std::vector<uint32_t> failed;
+    std::vector<GameRecord> worst; // Lost first, then most turns, then slowest
+    std::string pending;           // Formatted records, written every REPORT_CHUNK bytes
+
+    static uint64_t severity(const GameRecord &game)
+    {
+        return (uint64_t)(game.won ? game.turns : MAX_TURNS + 1) << 56 | std::min<uint64_t>(game.ns, (1ull << 56) - 1);
+    }
+
+    void keepWorst(const GameRecord &game)
+    {
+        if (worst.size() < REPORT_WORST || severity(game) > severity(worst.back()))
+        {
+            auto it = std::upper_bound(
+                worst.begin(),
+                worst.end(),
+                game,
+                [](const GameRecord &a, const GameRecord &b)
+                {
+                    return severity(a) > severity(b);
+                });
+            worst.insert(it, game);
+            if (worst.size() > REPORT_WORST)
+                worst.pop_back();
+        }
+    }
+
+    static constexpr size_t recordSize = 16 + sizeof(uint32_t) * MAX_TURNS;
+
+    // Field by field, so the record holds no padding bytes
+    void appendRecord(const GameRecord &game)
+    {
+        const uint16_t reserved = 0;
+        pending.append((const char *)&game.answer, sizeof(game.answer));
+        pending.append((const char *)&game.turns, sizeof(game.turns));
+        pending.append((const char *)&game.won, sizeof(game.won));
+        pending.append((const char *)&reserved, sizeof(reserved));
+        pending.append((const char *)&game.ns, sizeof(game.ns));
+        pending.append((const char *)game.guesses.data(), sizeof(uint32_t) * MAX_TURNS);
+    }
+
+    void add(const words &w, const GameRecord &game, bool binary)
+    {
+        histogram[game.won ? game.turns : 0]++;
+        turns += game.turns;
+        times.push_back(game.ns);
+        if (!game.won)
+            failed.push_back(game.answer);
+        keepWorst(game);
+
+        if (binary)
+        {
+            appendRecord(game);
+            return;
+        }
+
+        char us[32];
+        std::snprintf(us, sizeof(us), "%g", game.ns / 1000.0);
+        pending += w.strings[game.answer];
+        pending += ",";
+        pending += std::to_string(game.turns) + "," + std::to_string(game.won) + "," + us + ",";
+        for (int t = 0; t < game.turns; ++t)
+        {
+            if (t)
+                pending += " ";
+            pending += w.strings[game.guesses[t]];
+        }
+        pending += "\n";
+    }
+};
+
+/**
+ * Distributions of a dictionary run. Each thread collects its games in its own
+ * RunStats and writes its results in REPORT_CHUNK pieces; the distributions are
+ * merged once the thread is done. Only the times (8 bytes per game), the failed
+ * words and the REPORT_WORST longest games stay in memory.
+ *
+ * @note The lock is only taken to write a chunk and to merge
+ */
+struct RunReport
+{
+    RunStats total;
+
+    std::string path;
+    std::ofstream out;
+    bool binary;
+    std::mutex lock;
+
+    RunReport(const std::string &path) : path(path)
+    {
+        binary = path.size() < 4 || path.compare(path.size() - 4, 4, ".csv") != 0;
+        out.open(path, binary ? std::ios::binary | std::ios::trunc : std::ios::trunc);
+        if (!out.is_open())
+            std::cerr << "Warning: Could not write " << path << ", printing the summary only\n";
+
+        if (binary)
+        {
+            RunReportHeader header = {};
+            std::memcpy(header.magic, "WRDLRUN", 8);
+            header.version = RESULTS_VERSION;
+            header.wordLen = WORD_LEN;
+            header.maxTurns = MAX_TURNS;
+            header.recordSize = RunStats::recordSize;
+            out.write((const char *)&header, sizeof(header));
+        }
+        else
+            out << "answer,turns,won,us,guesses\n";
+    }
+
+    // Record a finished game in the stats of the thread that played it
+    inline void add(const words &w, RunStats &stats, const GameRecord &game)
+    {
+        stats.add(w, game, binary);
+        if (stats.pending.size() >= REPORT_CHUNK)
+            flush(stats);
+    }
+
+    // Write the buffered results of a thread
+    void flush(RunStats &stats)
+    {
+        if (stats.pending.empty())
+            return;
+
+        std::lock_guard<std::mutex> guard(lock);
+        out.write(stats.pending.data(), stats.pending.size());
+        stats.pending.clear();
+    }
+
+    /**
+     * Add the distributions of a thread that is done playing.
+     */
+    void merge(RunStats &stats)
+    {
+        flush(stats);
+
+        std::lock_guard<std::mutex> guard(lock);
+        for (int k = 0; k <= MAX_TURNS; ++k)
+            total.histogram[k] += stats.histogram[k];
+        total.turns += stats.turns;
+        total.times.insert(total.times.end(), stats.times.begin(), stats.times.end());
+        total.failed.insert(total.failed.end(), stats.failed.begin(), stats.failed.end());
+        for (const auto &game : stats.worst)
+            total.keepWorst(game);
+    }
+
+    /**
+     * @warning Call once every thread has merged
+     */
+    void print(const words &w)
+    {
+        out.flush();
+
+        auto &times = total.times;
+        auto &failed = total.failed;
+        const auto &histogram = total.histogram;
+        const size_t games = times.size();
+        if (games == 0)
+            return;
+
+        std::cout << "\n";
+        std::cout << "Winrate: " << 100.0 * (games - failed.size()) / games << " %\n";
+        std::cout << "Av.turn: " << (double)total.turns / games << "\n";
+        std::cout << "\n";
+
+        // Turn histogram, bars scaled to the biggest bucket
+        int biggest = *std::max_element(histogram.begin(), histogram.end());
+        for (int k = 1; k <= MAX_TURNS + 1; ++k)
+        {
+            bool lost = k > MAX_TURNS;
+            int count = histogram[lost ? 0 : k];
+            char line[64];
+            std::snprintf(line, sizeof(line), "%5s %7d %6.2f %% ", lost ? "lost" : std::to_string(k).c_str(),
+                          count, 100.0 * count / games);
+            std::cout << line << std::string(biggest ? 40 * count / biggest : 0, '#') << "\n";
+        }
+
+        // Tail latency
+        std::sort(times.begin(), times.end());
+        auto percentile = [&](double p)
+        {
+            return times[std::min(games - 1, (size_t)(p * games))] / 1000.0;
+        };
+        std::cout << "\nGame time: p50 " << percentile(0.5) << " us, p99 " << percentile(0.99)
+                  << " us, max " << times.back() / 1000.0 << " us\n";
+
+        if (!failed.empty())
+        {
+            std::sort(failed.begin(), failed.end());
+            std::cout << "\nFailed (" << failed.size() << "):";
+            for (size_t i = 0; i < std::min<size_t>(failed.size(), 20); ++i)
+                std::cout << " " << w.strings[failed[i]];
+            if (failed.size() > 20)
+                std::cout << " ...";
+            std::cout << "\n";
+        }
+
+        std::cout << "\nWorst games:\n";
+        for (const auto &game : total.worst)
+        {
+            std::cout << "  " << w.strings[game.answer] << (game.won ? "   " : " X ") << game.ns / 1000.0 << " us:";
+            for (int t = 0; t < game.turns; ++t)
+                std::cout << " " << w.strings[game.guesses[t]];
+            std::cout << "\n";
+        }
+
+        if (out.is_open())
+            std::cout << "\nPer word results written to " << path << "\n";
+        std::cout << "\n";
+    }
+};
+
+/**
+ * @return Index of word, exits if it is not in the dictionary
+ */
+uint32_t requireWord(const words &w, const std::string &word)
+{
+    auto it = std::find(w.strings.begin(), w.strings.end(), word);
+    if (it == w.strings.end())
+    {
+        std::cerr << word << " is an invalid word!\n";
+        exit(1);
+    }
+    return it - w.strings.begin();
+}
+
 // -------------------------------------------------------------------------------------------------
 
+/**
+ * Solve the whole dictionary, per word results are streamed to RESULTS_URL.
+ *
+ * @param hardMode Every guess must reuse the hints revealed so far, see isLegalGuess
+ */
 template <typename Algo>
-void runAlgorithm(const words &w, Algo algorithm, std::string firstGuess)
+void runAlgorithm(const words &w, Algo algorithm, std::string firstGuess, bool hardMode)
 {
-    int wins = 0, turns = 0;
-    for (const auto &currentWord : w.strings)
+    const uint32_t opener = requireWord(w, firstGuess);
+    RunReport report(RESULTS_URL);
+    RunStats stats;
+    WordleState state;
+    state.hardMode = hardMode;
+    for (int answer_idx : w.answers)
     {
+        const std::string &currentWord = w.strings[answer_idx];
         const std::string *guess = &firstGuess;
-        WordleState state;
+        state.reset();
         WordleGame game(currentWord, &state);
 
+        GameRecord record = {};
+        record.answer = answer_idx;
+        record.guesses[0] = opener;
+        auto start = std::chrono::steady_clock::now();
+
         while (game.turn(*guess) == Status::NEXT_TURN)
         {
             getCandidates(w, state);
+            TRACE_SCOPE(TraceEvent::ALGORITHM, state.candidates);
             guess = &algorithm(w, state);
+            record.guesses[game.currentTurn - 1] = guess - w.strings.data();
         }
 
-        if (game.status == Status::WIN)
-            wins++;
-        turns += game.currentTurn;
-
-        // Catches invalid firstGuess
-        // Comment out for a very slight performance boost
-
-        // if (game.status == Status::INVALID_TURN)
-        //  {
-        //  std::cerr << *guess << " is an invalid word!\n";
-        //  exit(1);
-        //  }
+        record.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        record.turns = game.currentTurn;
+        record.won = game.status == Status::WIN;
+        report.add(w, stats, record);
     }
 
-    double Avgwinrate = static_cast<double>(wins) / w.strings.size() * 100.0;
-    double Avgturns = static_cast<double>(turns) / w.strings.size();
-
-    std::cout << "\n";
-    std::cout << "Winrate: " << Avgwinrate << " %\n";
-    std::cout << "Av.turn: " << Avgturns << "\n";
-    std::cout << "\n";
+    report.merge(stats);
+    report.print(w);
 }
 
 template <typename Algo>
-void runAlgorithm(const words &w, Algo algorithm, std::string firstGuess, std::string wrd)
+void runAlgorithm(const words &w, Algo algorithm, std::string firstGuess, std::string wrd, bool hardMode)
 {
     const std::string *guess = &firstGuess;
     const std::string *suggestion;
     WordleState state;
+    state.hardMode = hardMode;
     WordleGame game(wrd, &state);
 
     while (game.turn(*guess) == Status::NEXT_TURN)
@@ -81,8 +381,9 @@ template <typename Algo>
 void runAlgorithm_stepthrough(const words &w, Algo algorithm, std::string firstGuess)
 {
     int wins = 0, turns = 0;
-    for (const auto &currentWord : w.strings)
+    for (int answer_idx : w.answers)
     {
+        const std::string &currentWord = w.strings[answer_idx];
         const std::string *guess = &firstGuess;
         const std::string *suggestion;
         WordleState state;
@@ -113,8 +414,8 @@ void runAlgorithm_stepthrough(const words &w, Algo algorithm, std::string firstG
         //  }
     }
 
-    double Avgwinrate = static_cast<double>(wins) / w.strings.size() * 100.0;
-    double Avgturns = static_cast<double>(turns) / w.strings.size();
+    double Avgwinrate = static_cast<double>(wins) / w.answers.size() * 100.0;
+    double Avgturns = static_cast<double>(turns) / w.answers.size();
 
     std::cout << "\n";
     std::cout << "Winrate: " << Avgwinrate << " %\n";
@@ -122,17 +423,440 @@ void runAlgorithm_stepthrough(const words &w, Algo algorithm, std::string firstG
     std::cout << "\n";
 }
 
+/**
+ * Solve the whole dictionary like runAlgorithm, spread across several threads.
+ *
+ * @param threads Worker count, <= 0 uses every hardware thread
+ *
+ * @note Totals are identical to the serial run for deterministic algorithms,
+ *       RESULTS_URL lists the words in chunks per thread, in the order they finished
+ */
+template <typename Algo>
+void runAlgorithm_parallel(const words &w, Algo algorithm, std::string firstGuess, int threads, bool hardMode)
+{
+    if (threads <= 0)
+        threads = defaultThreadCount();
+
+    const uint32_t opener = requireWord(w, firstGuess);
+    RunReport report(RESULTS_URL);
+    std::vector<WordleState> states(threads); // Reused by every game of a thread
+    std::vector<RunStats> stats(threads);
+    for (auto &state : states)
+        state.hardMode = hardMode;
+
+    parallelFor(
+        w.answers.size(),
+        threads,
+        [&](int tid, int slot)
+        {
+            const std::string *guess = &firstGuess;
+            WordleState &state = states[tid];
+            state.reset();
+            WordleGame game(w.strings[w.answers[slot]], &state);
+
+            GameRecord record = {};
+            record.answer = w.answers[slot];
+            record.guesses[0] = opener;
+            auto start = std::chrono::steady_clock::now();
+
+            while (game.turn(*guess) == Status::NEXT_TURN)
+            {
+                getCandidates(w, state);
+                TRACE_SCOPE(TraceEvent::ALGORITHM, state.candidates);
+                guess = &algorithm(w, state);
+                record.guesses[game.currentTurn - 1] = guess - w.strings.data();
+            }
+
+            record.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            record.turns = game.currentTurn;
+            record.won = game.status == Status::WIN;
+            report.add(w, stats[tid], record);
+        });
+
+    for (auto &threadStats : stats)
+        report.merge(threadStats);
+    report.print(w);
+}
+
+/**
+ * Solve the whole dictionary like runAlgorithm and count the heap allocations made
+ * inside the solve loop (turn, getCandidates and the algorithm).
+ *
+ * @note Needs a -DTRACK_ALLOCATIONS=true build. The first answer is played once
+ *       as a warm-up that sizes the reused state and the scratch arena
+ */
+template <typename Algo>
+void runAlgorithm_allocations(const words &w, Algo algorithm, std::string firstGuess)
+{
+    if (!TRACK_ALLOCATIONS)
+    {
+        std::cerr << "Allocation tracking is off, rebuild with -DTRACK_ALLOCATIONS=true\n";
+        exit(1);
+    }
+
+    WordleState state;
+    state.candidates.reserve(w.strings.size());
+
+    auto play = [&](int answer_idx)
+    {
+        const std::string *guess = &firstGuess;
+        state.reset();
+        WordleGame game(w.strings[answer_idx], &state);
+
+        while (game.turn(*guess) == Status::NEXT_TURN)
+        {
+            getCandidates(w, state);
+            TRACE_SCOPE(TraceEvent::ALGORITHM, state.candidates);
+            guess = &algorithm(w, state);
+        }
+    };
+
+    play(w.answers[0]);
+
+    uint64_t total = 0;
+    int allocatingGames = 0;
+    for (int answer_idx : w.answers)
+    {
+        uint64_t before = heapAllocations();
+        play(answer_idx);
+        uint64_t count = heapAllocations() - before;
+
+        total += count;
+        allocatingGames += count != 0;
+    }
+
+    std::cout << "\n";
+    std::cout << "Allocations: " << total << " in " << allocatingGames << "/" << w.answers.size() << " games\n";
+    std::cout << "Scratch peak: " << scratch().peak << " bytes\n";
+    std::cout << "\n";
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                        Opener Sweep
+// -------------------------------------------------------------------------------------------------
+
+struct OpenerResult
+{
+    uint32_t opener = 0; // Word index
+    int wins = 0;
+    int turns = 0;  // Summed like runAlgorithm, a loss counts MAX_TURNS
+    int worst = 0;  // Most turns any win took
+    int losses = 0;
+};
+
+/**
+ * Play every answer reaching a state at once: answers giving the same pattern end
+ * up in the same state, so the algorithm is asked once per state, not per game.
+ *
+ * @note Same bucketing as buildSolveTreeNode, so results match runAlgorithm
+ *       for deterministic algorithms, and the same per-thread, per-turn buckets
+ */
+template <typename Algo>
+void sweepNode(const words &w, Algo &algorithm, const WordleState &state, const std::vector<int> &reach,
+               uint32_t guess_idx, int turn, OpenerResult &result)
+{
+    auto &buckets = patternBuckets(turn);
+    if (w.e != nullptr)
+    {
+        const pattern_t *row = w.e->pattern_table + (size_t)guess_idx * w.answers.size();
+        TRACE_COUNT(tableBytes, reach.size() * sizeof(pattern_t));
+        for (int word_idx : reach)
+            buckets[row[w.e->column[word_idx]]].push_back(word_idx);
+    }
+    else
+    {
+        for (int word_idx : reach)
+            buckets[computePattern(w.chars(guess_idx), w.chars(word_idx))].push_back(word_idx);
+    }
+
+    const int solved = buckets[ALL_GREEN].size();
+    result.wins += solved;
+    result.turns += solved * turn;
+    if (solved)
+        result.worst = std::max(result.worst, turn);
+
+    for (int p = 0; p < ALL_GREEN; ++p)
+    {
+        if (buckets[p].empty())
+            continue;
+
+        if (turn == MAX_TURNS)
+        {
+            result.losses += buckets[p].size();
+            result.turns += buckets[p].size() * MAX_TURNS;
+            continue;
+        }
+
+        WordleState next = state;
+        WordleGame game(w.strings[buckets[p][0]], &next);
+        game.currentTurn = turn;
+        game.turn(w.strings[guess_idx]);
+        getCandidates(w, next);
+
+        uint32_t next_idx;
+        {
+            TRACE_SCOPE(TraceEvent::ALGORITHM, next.candidates);
+            next_idx = &algorithm(w, next) - w.strings.data();
+        }
+        sweepNode(w, algorithm, next, buckets[p], next_idx, turn + 1, result);
+    }
+}
+
+/**
+ * Score every opener against every answer, openers spread across threads.
+ *
+ * @param openers First guesses to compare, empty - every word
+ * @param threads Worker count, <= 0 uses every hardware thread
+ * @return One result per opener, best first: most wins, then fewest turns
+ *
+ * @warning algorithm must be deterministic, states are shared between games
+ */
+template <typename Algo>
+std::vector<OpenerResult> sweepOpeners(const words &w, Algo algorithm, const std::vector<std::string> &openers, int threads)
+{
+    std::vector<uint32_t> indices;
+    for (const auto &opener : openers)
+    {
+        auto it = std::find(w.strings.begin(), w.strings.end(), opener);
+        if (it == w.strings.end())
+        {
+            std::cerr << opener << " is an invalid word!\n";
+            exit(1);
+        }
+        indices.push_back(it - w.strings.begin());
+    }
+    if (openers.empty())
+    {
+        indices.resize(w.strings.size());
+        std::iota(indices.begin(), indices.end(), 0);
+    }
+
+    std::vector<OpenerResult> results(indices.size());
+    std::atomic<int> done{0};
+    std::mutex progressLock;
+    auto start = std::chrono::steady_clock::now();
+
+    parallelFor(
+        indices.size(),
+        threads,
+        [&](int, int job)
+        {
+            OpenerResult &result = results[job];
+            result.opener = indices[job];
+
+            WordleState state;
+            sweepNode(w, algorithm, state, w.answers, indices[job], 1, result);
+
+            int finished = done.fetch_add(1) + 1;
+            if (progressLock.try_lock())
+            {
+                double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::cerr << "\rSweep: " << finished << "/" << indices.size() << " openers, " << (int)s << " s" << std::flush;
+                progressLock.unlock();
+            }
+        });
+    std::cerr << "\n";
+
+    std::stable_sort(
+        results.begin(),
+        results.end(),
+        [](const OpenerResult &a, const OpenerResult &b)
+        {
+            if (a.wins != b.wins)
+                return a.wins > b.wins;
+            return a.turns < b.turns;
+        });
+    return results;
+}
+
+/**
+ * Print the best `top` openers and write every result to path as CSV.
+ */
+void printSweep(const words &w, const std::vector<OpenerResult> &results, size_t top, const std::string &path)
+{
+    const double games = w.answers.size();
+    std::cout << "\n Rank  Opener   Winrate %   Av.turn  Worst  Losses\n";
+    for (size_t rank = 0; rank < std::min(top, results.size()); ++rank)
+    {
+        const auto &r = results[rank];
+        std::cout << std::setw(5) << rank + 1 << "  " << w.strings[r.opener]
+                  << std::setw(WORD_LEN < 9 ? 14 - WORD_LEN : 4) << std::fixed << std::setprecision(3) << 100.0 * r.wins / games
+                  << std::setw(10) << std::setprecision(4) << r.turns / games
+                  << std::setw(7) << r.worst
+                  << std::setw(8) << r.losses << "\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "Could not write " << path << "\n";
+        return;
+    }
+    out << "rank,opener,wins,losses,winrate,avg_turns,worst\n";
+    for (size_t rank = 0; rank < results.size(); ++rank)
+    {
+        const auto &r = results[rank];
+        out << rank + 1 << "," << w.strings[r.opener] << "," << r.wins << "," << r.losses << ","
+            << 100.0 * r.wins / games << "," << r.turns / games << "," << r.worst << "\n";
+    }
+    std::cout << "All " << results.size() << " openers written to " << path << "\n";
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                        Weight Tuning
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Random search over NormalWeights for the lowest average turns over every answer.
+ *
+ * Each round perturbs the best weights so far into `population` candidates and
+ * scores them in parallel, one sweepNode pass per candidate. Perturbations shrink
+ * round by round. Candidates are drawn before scoring, so a seed always gives
+ * the same search whatever the thread count.
+ *
+ * @param rounds Search rounds
+ * @param population Weight sets scored per round
+ * @param threads Worker count, <= 0 uses every hardware thread
+ * @return Best weights found, the defaults if nothing beat them
+ */
+NormalWeights tuneNormalWeights(const words &w, const std::string &firstGuess, int rounds, int population, uint64_t seed, int threads)
+{
+    auto it = std::find(w.strings.begin(), w.strings.end(), firstGuess);
+    if (it == w.strings.end())
+    {
+        std::cerr << firstGuess << " is an invalid word!\n";
+        exit(1);
+    }
+    const uint32_t opener = it - w.strings.begin();
+
+    // Bonuses and penalties scale multiplicatively, the two thresholds step
+    static const std::array<int NormalWeights::*, 7> SCALED = {
+        &NormalWeights::earlyYellowBonus, &NormalWeights::earlyUnplayedBonus,
+        &NormalWeights::middleYellowBonus, &NormalWeights::middleUnplayedBonus,
+        &NormalWeights::repeatPenalty, &NormalWeights::candidateBonusMax, &NormalWeights::candidateBonusMin};
+
+    auto evaluate = [&](const NormalWeights &weights)
+    {
+        OpenerResult result;
+        NormalAlgorithm algorithm = {weights};
+        WordleState state;
+        sweepNode(w, algorithm, state, w.answers, opener, 1, result);
+        return result;
+    };
+    auto better = [](const OpenerResult &a, const OpenerResult &b)
+    {
+        if (a.turns != b.turns)
+            return a.turns < b.turns;
+        return a.wins > b.wins;
+    };
+    auto print = [&](const char *label, const OpenerResult &r)
+    {
+        std::cout << label << 100.0 * r.wins / w.answers.size() << " % wins, "
+                  << (double)r.turns / w.answers.size() << " av.turn\n";
+    };
+
+    NormalWeights best;
+    OpenerResult bestResult = evaluate(best);
+    print("Defaults: ", bestResult);
+
+    std::vector<NormalWeights> candidates(population);
+    std::vector<OpenerResult> results(population);
+    for (int round = 0; round < rounds; ++round)
+    {
+        const double sigma = 0.05 + 0.45 * (1.0 - (double)round / rounds);
+        std::mt19937_64 gen(seed + round);
+        std::normal_distribution<double> noise(0.0, sigma);
+        std::uniform_int_distribution<int> step(-1, 1);
+
+        for (auto &candidate : candidates)
+        {
+            candidate = best;
+            for (auto field : SCALED)
+                candidate.*field = (int)std::lround(candidate.*field * std::exp(noise(gen)));
+            candidate.phaseSplit = std::clamp(candidate.phaseSplit + step(gen), 0, 2 * WORD_LEN);
+            candidate.repeatUnplayedMin = std::clamp(candidate.repeatUnplayedMin + step(gen), 0, 26);
+        }
+
+        parallelFor(
+            population,
+            threads,
+            [&](int, int job)
+            {
+                results[job] = evaluate(candidates[job]);
+            });
+
+        // Lowest index wins ties, so the outcome does not depend on scheduling
+        for (int job = 0; job < population; ++job)
+        {
+            if (better(results[job], bestResult))
+            {
+                best = candidates[job];
+                bestResult = results[job];
+            }
+        }
+
+        std::cout << "Round " << round + 1 << "/" << rounds << ": ";
+        print("", bestResult);
+    }
+
+    std::cout << "\nNormalWeights = {" << best.earlyYellowBonus << ", " << best.earlyUnplayedBonus << ", "
+              << best.middleYellowBonus << ", " << best.middleUnplayedBonus << ", " << best.phaseSplit << ", "
+              << best.repeatPenalty << ", " << best.repeatUnplayedMin << ", "
+              << best.candidateBonusMax << ", " << best.candidateBonusMin << "}\n";
+    return best;
+}
+
+/**
+ * Solve the whole dictionary by walking a compiled solve tree, no scorer or
+ * candidate filtering involved.
+ */
+void runAlgorithm(const words &w, const SolveTree &tree)
+{
+    RunReport report(RESULTS_URL);
+    RunStats stats;
+    for (int answer_idx : w.answers)
+    {
+        const std::string &currentWord = w.strings[answer_idx];
+        WordleState state;
+        WordleGame game(currentWord, &state);
+
+        GameRecord record = {};
+        record.answer = answer_idx;
+        auto start = std::chrono::steady_clock::now();
+
+        int node = 0;
+        while (node != -1)
+        {
+            const std::string &guess = w.strings[tree.guess(node)];
+            record.guesses[game.currentTurn - 1] = tree.guess(node);
+            if (game.turn(guess) != Status::NEXT_TURN)
+                break;
+
+            node = tree.next(node, computePattern(guess.c_str(), currentWord.c_str()));
+        }
+
+        record.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        record.turns = game.currentTurn;
+        record.won = game.status == Status::WIN;
+        report.add(w, stats, record);
+    }
+
+    report.merge(stats);
+    report.print(w);
+}
+
 void playWordle(const words &w, std::string word)
 {
     if (word.length() == 0)
     {
         std::random_device rd;
         std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dist(0, 14800);
+        std::uniform_int_distribution<> dist(0, w.answers.size() - 1);
         int rand = dist(gen);
 
         // Randomize word
-        word = w.strings[rand];
+        word = w.strings[w.answers[rand]];
     }
 
     WordleState state;
@@ -174,9 +898,10 @@ void autoWordle(const words &w, std::string word, const std::vector<std::string>
 }
 
 template <typename Algo>
-void playSecretWord(const words &w, Algo algorithm)
+void playSecretWord(const words &w, Algo algorithm, bool hardMode)
 {
     WordleState state;
+    state.hardMode = hardMode;
     WordleGame game("dummy", &state);
     std::string input, guess, result;
     int turn = 1;
@@ -193,43 +918,113 @@ void playSecretWord(const words &w, Algo algorithm)
 
         guess = input.substr(0, WORD_LEN);
         result = input.substr(WORD_LEN + 1, WORD_LEN);
+        std::transform(guess.begin(), guess.end(), guess.begin(), ::tolower);
 
         // Input guess
-        for (int i = 0; i < WORD_LEN; i++)
+        bool letters = std::all_of(
+            guess.begin(),
+            guess.end(),
+            [](char c)
+            {
+                return c >= 'a' && c <= 'z';
+            });
+        if (!letters)
+        {
+            std::cerr << "Invalid guess: " << guess << std::endl;
+            continue;
+        }
+
+        if (state.hardMode && !isLegalGuess(state, guess.c_str()))
+        {
+            std::cerr << guess << " breaks the hard mode constraints (keep the greens, reuse every revealed letter)" << std::endl;
+            continue;
+        }
+
+        if (!applyFeedback(state, guess, result))
+        {
+            std::cerr << "followup error: " << result << std::endl;
+            continue;
+        }
+
+        game.currentTurn = ++turn;
+        getCandidates(w, state);
+        result = algorithm(w, state);
+        printTurn(w, game, guess, result);
+    }
+}
+
+/**
+ * Like playSecretWord, but suggestions come from a solve tree. Only works while
+ * the played guesses are the ones the tree suggested.
+ */
+void playSecretWord(const words &w, const SolveTree &tree)
+{
+    std::string input, guess, result;
+    int node = 0;
+    int turn = 1;
+
+    std::cout << "Tree suggestion: " << w.strings[tree.guess(node)] << "\n";
+    while (turn <= MAX_TURNS)
+    {
+        // Get input
+        std::cout << "Input: ";
+        std::getline(std::cin, input);
+        if (input.length() != WORD_LEN * 2 + 1)
+            continue;
+
+        guess = input.substr(0, WORD_LEN);
+        result = input.substr(WORD_LEN + 1, WORD_LEN);
+        std::transform(guess.begin(), guess.end(), guess.begin(), ::tolower);
+
+        if (guess != w.strings[tree.guess(node)])
         {
-            char c = result[i];
+            std::cerr << "Tree only knows " << w.strings[tree.guess(node)] << " here\n";
+            continue;
+        }
 
+        // Input result
+        pattern_t pattern = 0;
+        bool valid = true;
+        for (char c : result)
+        {
             switch (c)
             {
             case 'G':
             case 'g':
-                state.green[i] = guess[i];
-                state.set_requireMask(i, guess[i] - 'a');
-                state.maxSameChar[guess[i] - 'a']++;
+                pattern = pattern * 3 + 2;
                 break;
-
             case 'Y':
             case 'y':
-                state.set_yellow(i, guess[i] - 'a');
-                state.set_requireMask(i, guess[i] - 'a');
-                state.maxSameChar[guess[i] - 'a']++;
+                pattern = pattern * 3 + 1;
                 break;
-
             case 'X':
             case 'x':
-                state.set_grey(guess[i] - 'a');
+                pattern = pattern * 3;
                 break;
-
             default:
                 std::cerr << "followup error: " << c << std::endl;
+                valid = false;
                 break;
             }
         }
 
-        game.currentTurn = ++turn;
-        getCandidates(w, state);
-        result = algorithm(w, state);
-        printTurn(w, game, guess, result);
+        if (!valid)
+            continue;
+
+        if (pattern == ALL_GREEN)
+            break;
+
+        node = tree.next(node, pattern);
+        if (node == -1)
+        {
+            std::cerr << "No answer gives that result\n";
+            break;
+        }
+
+        turn++;
+        std::cout << "-------------------------------------------------------------------------------------\n";
+        std::cout << turn - 1 << "/6 - " << guess << "\n";
+        std::cout << "Tree suggestion: " << w.strings[tree.guess(node)] << "\n";
     }
 }
 
@@ -299,21 +1094,65 @@ inline void printMainMenu()
     std::cout << "4 - Algo Word\n";
     std::cout << "5 - Algo Dictionary\n";
     std::cout << "6 - Algo Dictionary Stepthrough\n";
+    std::cout << "7 - Algo Dictionary Parallel\n";
+    std::cout << "8 - Build Solve Tree\n";
+    std::cout << "9 - Solve Tree Dictionary\n";
+    std::cout << "10 - Play Unknown Wordle (Solve Tree)\n";
+    std::cout << "11 - Algo Dictionary Allocations\n";
+    std::cout << "12 - Opener Sweep\n";
+    std::cout << "13 - Tune algo_normal Weights\n";
     std::cout << "--------------------\n";
     std::cout << ">> ";
 }
 
 int main(int argc, char const *argv[])
 {
+    // wordle [dictionary] [--answers PATH] [--first WORD] [--secret WORD], defaults to
+    // WORD_URL, ANSWER_URL and the DEFAULT_WORDS of this word length
+    std::string dictionary = WORD_URL, answers = ANSWER_URL;
+    std::string firstGuess = DEFAULT_WORDS.opener, secretWord = DEFAULT_WORDS.secret;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--answers" && i + 1 < argc)
+            answers = argv[++i];
+        else if (arg == "--first" && i + 1 < argc)
+            firstGuess = argv[++i];
+        else if (arg == "--secret" && i + 1 < argc)
+            secretWord = argv[++i];
+        else if (arg.rfind("--", 0) != 0)
+            dictionary = arg;
+        else
+        {
+            std::cerr << "Usage: wordle [DICTIONARY] [--answers PATH] [--first WORD] [--secret WORD]\n";
+            return 1;
+        }
+    }
+
     words w;
-    loadWords(w);
+    loadWords(w, false, dictionary, answers);
 
     // Constants
-    const std::vector<std::string> GUESS_ARRAY = {"salet", "gourd", "brunt", "fruit"};
+#if WORD_LEN == 5
+    const std::vector<std::string> GUESS_ARRAY = {firstGuess, "gourd", "brunt", secretWord};
+#else
+    const std::vector<std::string> GUESS_ARRAY = {firstGuess, DEFAULT_WORDS.probe, secretWord};
+#endif
     const auto ALGORITHM = algo_test1;
-    const auto SECRET_WORD = "fruit";
-    const auto FIRST_GUESS = "salet";
+    const std::string SECRET_WORD = secretWord; // --secret, "" - Random Word (menu 1)
+    const std::string FIRST_GUESS = firstGuess; // --first
+    const std::vector<std::string> SWEEP_OPENERS = {}; // {} - Every word
+    const int THREADS = 0; // 0 - All hardware threads
+    const int TUNE_ROUNDS = 10;
+    const int TUNE_POPULATION = 16; // Weight sets scored per round
+    const bool TRANSPOSITION = true;
+    const bool HARD_MODE = false; // Guesses must reuse every revealed hint (menu 3, 4, 5, 7)
+
+    // Remembers ALGORITHM's answer per state, see CachedAlgorithm
+    TranspositionCache cache(1 << 20);
+    const CachedAlgorithm<decltype(ALGORITHM)> SOLVER = {ALGORITHM, TRANSPOSITION ? &cache : nullptr};
 
+    SolveTree tree;
     printMainMenu();
     int input;
     std::cin >> input;
@@ -330,28 +1169,76 @@ int main(int argc, char const *argv[])
     case 3:
         /*
             G|g - Green
-            Y|g - Yellow
+            Y|y - Yellow
             X|x - Grey
 
-            GUESS|SPACE|RESULT
+            GUESS|ANY CHAR|RESULT, either case
             ------------------
             words yxgyy
             SALET>GGGGX
             MilKY|xyXxG
         */
-        playSecretWord(w, ALGORITHM);
+        playSecretWord(w, SOLVER, HARD_MODE);
         break;
     case 4:
         // Solve WORD with algorithm and starting word
-        runAlgorithm(w, ALGORITHM, FIRST_GUESS, SECRET_WORD);
+        runAlgorithm(w, SOLVER, FIRST_GUESS, SECRET_WORD, HARD_MODE);
         break;
     case 5:
         // Solve DICTIONARY with algorithm and starting word
-        runAlgorithm(w, ALGORITHM, FIRST_GUESS);
+        runAlgorithm(w, SOLVER, FIRST_GUESS, HARD_MODE);
+        cache.printStats();
         break;
     case 6:
         // Solve DICTIONARY, but printed one word at a time
-        runAlgorithm_stepthrough(w, ALGORITHM, FIRST_GUESS);
+        runAlgorithm_stepthrough(w, SOLVER, FIRST_GUESS);
+        break;
+    case 7:
+        // Solve DICTIONARY on every core
+        runAlgorithm_parallel(w, SOLVER, FIRST_GUESS, THREADS, HARD_MODE);
+        cache.printStats();
+        break;
+    case 8:
+        // Compile ALGORITHM into a decision tree file
+        buildSolveTree(w, ALGORITHM, FIRST_GUESS, tree);
+        if (!saveSolveTree(w, tree, TREE_URL))
+            std::cerr << "Could not write " << TREE_URL << "\n";
+        std::cout << "Solve tree: " << tree.nodes.size() << " nodes\n";
+        break;
+    case 9:
+        // Solve DICTIONARY with a compiled tree
+        if (!loadSolveTree(w, tree, TREE_URL))
+        {
+            std::cerr << "Missing or outdated " << TREE_URL << ", build it first\n";
+            exit(1);
+        }
+        runAlgorithm(w, tree);
+        break;
+    case 10:
+        // Same as 3, suggestions come from the tree
+        if (!loadSolveTree(w, tree, TREE_URL))
+        {
+            std::cerr << "Missing or outdated " << TREE_URL << ", build it first\n";
+            exit(1);
+        }
+        playSecretWord(w, tree);
+        break;
+    case 11:
+        // Count heap allocations inside the solve loop, needs TRACK_ALLOCATIONS
+        runAlgorithm_allocations(w, SOLVER, FIRST_GUESS);
+        break;
+    case 12:
+        // Rank first guesses by ALGORITHM's results over every answer
+        printSweep(w, sweepOpeners(w, SOLVER, SWEEP_OPENERS, THREADS), 25, SWEEP_URL);
+        cache.printStats();
+        break;
+    case 13:
+        // Search algo_normal weights for the lowest average turns from FIRST_GUESS
+        tuneNormalWeights(w, FIRST_GUESS, TUNE_ROUNDS, TUNE_POPULATION, 42, THREADS);
         break;
     }
+
+    // Per turn timings and counters of whatever ran, TRACE_HOT_PATH builds only
+    if (TRACE_HOT_PATH)
+        flushTrace(TRACE_URL);
 }
\ No newline at end of file
@@ -2,14 +2,25 @@
 #include <random>
 #include "wordle-game.cpp"
 
-// WEIGHTS
-int CANDIDATE_BONUS = 150;
-int REPEATING_PENALTY = 200;
-int UNPLAYED_CHAR_BONUS = 200;
-int YELLOW_CHAR_BONUS = 250;
+// Heuristic weights
+struct NormalWeights;
+struct NormalAlgorithm;
+
+// Scoring
+enum class Metric : int;
+struct GuessScore;
+struct ScorePolicy;
+struct ScoredAlgorithm;
+inline GuessScore scoreGuess(const pattern_t *row, const uint32_t *cols, size_t n, const double *klogk);
+inline int compareScores(const GuessScore &a, const GuessScore &b, const ScorePolicy &policy);
+void suggestBatch(const words &w, const std::vector<const WordleState *> &states,
+                  const ScorePolicy &policy, std::vector<uint32_t> &guesses);
 
 // Utility
-struct VectorHash;
+struct TranspositionCache;
+template <typename Algo>
+struct CachedAlgorithm;
+uint64_t stateHash(const WordleState &state, bool constraints);
 
 // Algorithms
 const std::string &algo_idxfirst(const words &w, const WordleState &state);
@@ -17,23 +28,72 @@ const std::string &algo_idxmiddle(const words &w, const WordleState &state);
 const std::string &algo_idxlast(const words &w, const WordleState &state);
 const std::string &algo_rand(const words &w, const WordleState &state);
 const std::string &algo_normal(const words &w, const WordleState &state);
+const std::string &algo_normal_weighted(const words &w, const WordleState &state, const NormalWeights &weights);
 const std::string &algo_test1(const words &w, const WordleState &state);
 const std::string &algo_entropy(const words &w, const WordleState &state);
 const std::string &algo_entropy_fast(const words &w, const WordleState &state);
+const std::string &algo_entropy_full(const words &w, const WordleState &state);
+const std::string &algo_minimax(const words &w, const WordleState &state);
+const std::string &algo_expected(const words &w, const WordleState &state);
+const std::string &algo_mostparts(const words &w, const WordleState &state);
 
-struct VectorHash
+/**
+ * Weights of algo_normal. The game is "early" while at most phaseSplit letters
+ * are green (or forced) or yellow, "middle" after.
+ */
+struct NormalWeights
+{
+    int earlyYellowBonus = 300;
+    int earlyUnplayedBonus = 1000;
+    int middleYellowBonus = 550;
+    int middleUnplayedBonus = 500;
+    int phaseSplit = 3;
+    int repeatPenalty = 400;       // Per copy of a repeated letter
+    int repeatUnplayedMin = 21;    // Repeats are only penalized while this many letters are unplayed
+    int candidateBonusMax = 700;   // Candidate bonus with one candidate left,
+    int candidateBonusMin = 150;   // falling linearly to this with every answer left
+    bool coverageFallback = true;  // No positive score: rank by unplayed letter coverage, false - first candidate
+};
+
+// algo_normal with its own weights, safe to run with different weights at once
+struct NormalAlgorithm
 {
-    size_t operator()(const std::vector<short> &v) const
+    NormalWeights weights;
+
+    const std::string &operator()(const words &w, const WordleState &state) const
     {
-        std::size_t hash = 0;
-        for (short i : v)
-        {
-            hash ^= std::hash<short>()(i) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-        }
-        return hash;
+        return algo_normal_weighted(w, state, weights);
     }
 };
 
+enum class Metric : int
+{
+    NONE = 0,
+    ENTROPY,       // Highest information
+    EXPECTED_SIZE, // Lowest expected remaining candidates, sum k^2 / N
+    MINIMAX,       // Smallest worst case bucket
+    MOST_PARTS     // Most non-empty buckets
+};
+
+struct GuessScore
+{
+    double klogk = 0.0;      // sum k*log2(k), entropy = log2(N) - klogk / N
+    uint64_t sumSquares = 0; // sum k^2
+    int largest = 0;         // Biggest bucket
+    int parts = 0;           // Non-empty buckets
+    bool solves = false;     // Guess is a candidate itself
+};
+
+/**
+ * Metrics compared in order, the next one only breaks ties of the previous.
+ * A guess that can win this turn breaks any remaining tie.
+ */
+struct ScorePolicy
+{
+    std::array<Metric, 4> order = {Metric::ENTROPY};
+    bool allGuesses = false; // Also consider words that are not candidates
+};
+
 // -------------------------------------------------------------------------------------------------
 //                                   Algorithm Implementations
 // -------------------------------------------------------------------------------------------------
@@ -64,37 +124,44 @@ const std::string &algo_rand(const words &w, const WordleState &state)
 }
 
 const std::string &algo_normal(const words &w, const WordleState &state)
+{
+    static const NormalWeights weights;
+    return algo_normal_weighted(w, state, weights);
+}
+
+const std::string &algo_normal_weighted(const words &w, const WordleState &state, const NormalWeights &weights)
 {
     if (state.candidates.size() == 1)
         return w.strings[state.candidates[0]];
 
     uint32_t unplayedChars = ~(state.grey | state.requiredCharMask);
 
+    // Read from the counts getCandidates keeps, no pass over the candidates
     int charFrequency[26] = {0};
-    std::array<uint32_t, 5> positionCharMask = {0};
-    for (int word_idx : state.candidates)
+    std::array<uint32_t, WORD_LEN> positionCharMask = {0};
+    for (int i = 0; i < WORD_LEN; i++)
     {
-        const auto &word = w.strings[word_idx];
-        for (int i = 0; i < WORD_LEN; i++)
+        if (state.solvedLetters[i])
+            continue;
+
+        for (int c = 0; c < 26; ++c)
         {
-            if (state.solvedLetters[i])
+            int count = state.positionCharCount[i][c];
+            if (count == 0)
                 continue;
 
-            char ch = word[i];
-            uint32_t chBit = 1u << (ch - 'a');
-
             // Log char in given position
-            positionCharMask[i] |= chBit;
+            positionCharMask[i] |= 1u << c;
 
             // Log unplayed char frequency
-            if (unplayedChars & chBit)
-                charFrequency[ch - 'a']++;
+            if (unplayedChars & (1u << c))
+                charFrequency[c] += count;
         }
     }
 
     // Do all candidates share a single letter at a position, not marked as green
     auto solvedLettersLocal = state.solvedLetters;
-    for (int i = 0; i < 5; i++)
+    for (int i = 0; i < WORD_LEN; i++)
     {
         auto mask = positionCharMask[i];
         if (mask && !(mask & (mask - 1)))
@@ -107,10 +174,6 @@ const std::string &algo_normal(const words &w, const WordleState &state)
         }
     }
 
-    std::vector<int> shortlist;
-    shortlist.resize(w.strings.size() - 1);
-    std::iota(shortlist.begin(), shortlist.end(), 1);
-
     // Count green & yellows
     int greenLetters = 0;
     int yellowLetters = 0;
@@ -127,68 +190,131 @@ const std::string &algo_normal(const words &w, const WordleState &state)
     yellowLetters = std::__popcount(YellowLettersMask);
     unplayedCharsCount = std::__popcount(unplayedChars) - 6; // 32 - 6 = 26
 
+    int yellowBonus, unplayedBonus;
+
     // Early Game
-    if ((greenLetters + yellowLetters) <= 3)
+    if ((greenLetters + yellowLetters) <= weights.phaseSplit)
     {
-        YELLOW_CHAR_BONUS = 300;
-        UNPLAYED_CHAR_BONUS = 1000;
+        yellowBonus = weights.earlyYellowBonus;
+        unplayedBonus = weights.earlyUnplayedBonus;
     }
     // Middle Game
-    else if ((greenLetters + yellowLetters) > 3)
+    else
     {
-        YELLOW_CHAR_BONUS = 550;
-        UNPLAYED_CHAR_BONUS = 500;
+        yellowBonus = weights.middleYellowBonus;
+        unplayedBonus = weights.middleUnplayedBonus;
     }
 
-    REPEATING_PENALTY = (unplayedCharsCount / 21) * 400;
-    CANDIDATE_BONUS = 700 - (state.candidates.size() - 1) * (700 - 150) / (w.strings.size() - 1);
-
-    int best_score = 0, current_score, best_idx;
-    std::unordered_set<int> candidatesSet(state.candidates.begin(), state.candidates.end());
-    for (int word_idx : shortlist)
+    const int repeatPenalty = unplayedCharsCount >= weights.repeatUnplayedMin ? weights.repeatPenalty : 0;
+    const int candidateBonus = weights.candidateBonusMax -
+                               (int64_t)(state.candidates.size() - 1) * (weights.candidateBonusMax - weights.candidateBonusMin) /
+                                   (int64_t)std::max<size_t>(w.answers.size() - 1, 1);
+
+    // Scoring words 1..N-1 in order, charFrequency keeps counting every letter it
+    // sees. Its value at a letter is the dictionary running count letter_runs,
+    // offset by the start frequency minus what word 0 (never scored) contributed.
+    const size_t N = w.strings.size();
+    int offset[26], yellowTerm[26];
+    uint8_t unplayed[26];
+    const char *first = w.chars(0);
+    for (int c = 0; c < 26; ++c)
     {
-        const auto &word = w.strings[word_idx];
+        offset[c] = charFrequency[c] - (int)std::count(first, first + WORD_LEN, 'a' + c);
+        yellowTerm[c] = (YellowLettersMask & (1u << c)) ? yellowBonus : 0;
+        unplayed[c] = (unplayedChars >> c) & 1;
+    }
 
-        current_score = 0;
-        int repeatChars[26] = {0};
-        auto local_unplayedChars = unplayedChars;
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
+    int *__restrict score = arena.alloc<int>(N);
 
-        // Candidate Bonus
-        if (candidatesSet.count(word_idx))
-            current_score += CANDIDATE_BONUS;
+    // Candidate Bonus
+    const uint64_t *candidateBits = state.candidate_bits.bits.data();
+    if (state.candidate_bits.empty())
+    {
+        uint64_t *bits = arena.alloc<uint64_t>((N + 63) / 64);
+        std::fill(bits, bits + (N + 63) / 64, 0);
+        for (int word_idx : state.candidates)
+            bits[word_idx >> 6] |= 1ull << (word_idx & 63);
+        candidateBits = bits;
+    }
+    for (size_t word_idx = 0; word_idx < N; ++word_idx)
+        score[word_idx] = candidateBonus & -(int)((candidateBits[word_idx >> 6] >> (word_idx & 63)) & 1);
 
-        for (int i = 0; i < WORD_LEN; i++)
+    // One branch-free pass per position over the letter features
+    for (int i = 0; i < WORD_LEN; i++)
+    {
+        const uint8_t *__restrict letters = w.position_letters[i].data();
+        const uint8_t *__restrict firsts = w.first_letters[i].data();
+        const uint32_t *__restrict runs = w.letter_runs[i].data();
+        for (size_t word_idx = 0; word_idx < N; ++word_idx)
         {
-            char ch = word[i];
-            uint8_t ch_idx = ch - 'a';
-            uint8_t ch_count = ++charFrequency[ch_idx];
-            uint32_t ch_mask = 1u << (ch_idx);
-
-            // Unplayed chars Bonus
-            if ((unplayedChars & ch_mask) && (local_unplayedChars & ch_mask))
-            {
-                current_score += UNPLAYED_CHAR_BONUS;
-                current_score += charFrequency[ch_idx];
+            int c = letters[word_idx];
+            int frequency = offset[c] + (int)runs[word_idx];
+            int ch_count = frequency & 0xFF; // As the uint8_t it used to be
 
-                local_unplayedChars &= ~ch_mask;
-            }
+            // Unplayed chars Bonus, first copy in the word only
+            int unplayedMask = -(int)(firsts[word_idx] & unplayed[c]);
+            score[word_idx] += unplayedMask & (unplayedBonus + frequency);
 
             // Yellow bonus
-            if (YellowLettersMask & ch_mask)
-                current_score += YELLOW_CHAR_BONUS;
+            score[word_idx] += yellowTerm[c];
 
             // Repeat penalty
-            if (ch_count > 1)
-                current_score -= REPEATING_PENALTY * ch_count;
+            score[word_idx] -= (ch_count > 1) * repeatPenalty * ch_count;
         }
+    }
 
-        if (current_score > best_score)
+    // First word with the highest positive score, -1 if none. Word 0 is never
+    // picked, in hard mode only the legal pool is (the dense passes stay cheaper
+    // than gathering the pool's features)
+    auto firstBest = [&]() -> int
+    {
+        int best_score = 0;
+        if (state.hardMode && !state.guessPool.empty())
         {
-            // std::cout << "\nword: " << w.strings[word_idx] << " - " << current_score << "\n";
-            best_score = current_score;
-            best_idx = word_idx;
+            int best_idx = -1;
+            for (int word_idx : state.guessPool)
+            {
+                if (word_idx != 0 && score[word_idx] > best_score)
+                {
+                    best_score = score[word_idx];
+                    best_idx = word_idx;
+                }
+            }
+            return best_idx;
         }
+
+        for (size_t word_idx = 1; word_idx < N; ++word_idx)
+            best_score = std::max(best_score, score[word_idx]);
+        if (best_score == 0)
+            return -1;
+
+        int best_idx = 1;
+        while (score[best_idx] != best_score)
+            ++best_idx;
+        return best_idx;
+    };
+
+    int best_idx = firstBest();
+    if (best_idx == -1 && weights.coverageFallback)
+    {
+        // Repeat penalties outweigh every bonus: rank by the unplayed letter
+        // coverage alone, each distinct letter worth its candidate frequency
+        std::fill(score, score + N, 0);
+        for (int i = 0; i < WORD_LEN; i++)
+        {
+            const uint8_t *__restrict letters = w.position_letters[i].data();
+            const uint8_t *__restrict firsts = w.first_letters[i].data();
+            for (size_t word_idx = 0; word_idx < N; ++word_idx)
+                score[word_idx] += firsts[word_idx] * charFrequency[letters[word_idx]];
+        }
+        best_idx = firstBest();
     }
+
+    // No unplayed letter left, or the fallback is off
+    if (best_idx == -1)
+        return w.strings[state.candidates[0]];
     return w.strings[best_idx];
 }
 
@@ -198,24 +324,26 @@ const std::string &algo_test1(const words &w, const WordleState &state)
         return w.strings[state.candidates[0]];
 
     // Variables:
-    std::array<bool, 5> solvedLettersLocal = state.solvedLetters;
+    std::array<bool, WORD_LEN> solvedLettersLocal = state.solvedLetters;
     uint32_t unplayedChars = ~(state.grey | state.requiredCharMask);
     uint32_t unplayedCharsMask = 0;
-    std::vector<std::pair<char, int>> sortedChFreq;
-    sortedChFreq.reserve(26);
+    std::array<std::pair<char, int>, 26> sortedChFreq;
+    int letterCount = 0;
 
     int temp_chFreq[26] = {0};
-    std::array<uint32_t, 5> temp_posCharMask = {0};
-    for (int word_idx : state.candidates)
+    std::array<uint32_t, WORD_LEN> temp_posCharMask = {0};
+    for (int i = 0; i < WORD_LEN; i++)
     {
-        const auto &word = w.strings[word_idx];
-        for (int i = 0; i < WORD_LEN; i++)
+        if (state.solvedLetters[i])
+            continue;
+
+        for (int c = 0; c < 26; ++c)
         {
-            if (state.solvedLetters[i])
+            int count = state.positionCharCount[i][c];
+            if (count == 0)
                 continue;
 
-            char ch = word[i];
-            uint32_t chBit = 1u << (ch - 'a');
+            uint32_t chBit = 1u << c;
 
             // Log char in given position
             temp_posCharMask[i] |= chBit;
@@ -223,14 +351,14 @@ const std::string &algo_test1(const words &w, const WordleState &state)
             // Log unplayed char frequency
             if (unplayedChars & chBit)
             {
-                temp_chFreq[ch - 'a']++;
+                temp_chFreq[c] += count;
                 unplayedCharsMask |= chBit;
             }
         }
     }
 
     // Do all candidates use only one letter in a position not marked as green?
-    for (int i = 0; i < 5; i++)
+    for (int i = 0; i < WORD_LEN; i++)
     {
         uint32_t charMask = temp_posCharMask[i];
         if (charMask && !(charMask & (charMask - 1)))
@@ -239,49 +367,74 @@ const std::string &algo_test1(const words &w, const WordleState &state)
 
             // Remove letter from char frequency array
             // because it is mandatory
+            // NOTE: the +1 offset is what the tuned results were measured with,
+            //       only the out-of-bounds write for 'z' is dropped
             uint8_t idx = __builtin_ctz(charMask) + 1;
-            temp_chFreq[idx] = 0;
+            if (idx < 26)
+                temp_chFreq[idx] = 0;
         }
     }
 
     // Prepare the frequency char vector
     for (int i = 0; i < 26; ++i)
         if (temp_chFreq[i] > 0)
-            sortedChFreq.emplace_back('a' + i, temp_chFreq[i]);
+            sortedChFreq[letterCount++] = {(char)('a' + i), temp_chFreq[i]};
 
-    if (sortedChFreq.size() > 0)
+    if (letterCount > 0)
     {
         std::sort(
             sortedChFreq.begin(),
-            sortedChFreq.end(),
+            sortedChFreq.begin() + letterCount,
             [](const auto &a, const auto &b)
             {
                 return a.second > b.second;
             });
     }
 
-    std::vector<int> shortlist = state.candidates;
-    for (int i = 0; i < sortedChFreq.size() && shortlist.size() > 0; ++i)
+    // Bitset path: each intersection is a single AND over the dictionary
+    if (!state.candidate_bits.empty())
+    {
+        thread_local WordBitset shortlist, next;
+        shortlist = state.candidate_bits;
+        for (int i = 0; i < letterCount; ++i)
+        {
+            next = shortlist;
+            next.and_with(w.letter_bits[sortedChFreq[i].first - 'a']);
+
+            if (next.any())
+                std::swap(shortlist, next);
+        }
+
+        return w.strings[shortlist.nth(shortlist.count() / 2)];
+    }
+
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
+    int *shortlist = arena.alloc<int>(state.candidates.size());
+    int *next = arena.alloc<int>(state.candidates.size());
+    size_t count = state.candidates.size();
+    std::copy(state.candidates.begin(), state.candidates.end(), shortlist);
+
+    for (int i = 0; i < letterCount; ++i)
     {
         char ch = sortedChFreq[i].first;
-        const auto &current = w.inv_index.find(ch)->second;
+        const auto &current = w.inv_index[ch - 'a'];
 
         // intersect current shortlist with words that contain ch
-        std::vector<int> next;
-        next.reserve(shortlist.size());
-        std::set_intersection(
-            shortlist.begin(), shortlist.end(),
+        TRACE_COUNT(intersections, 1);
+        int *end = std::set_intersection(
+            shortlist, shortlist + count,
             current.begin(), current.end(),
-            std::back_inserter(next));
+            next);
 
-        if (!next.empty())
-            shortlist = std::move(next);
+        if (end != next)
+        {
+            count = end - next;
+            std::swap(shortlist, next);
+        }
     }
 
-    if (shortlist.size() == 1)
-        return w.strings[shortlist[0]];
-    else
-        return w.strings[shortlist[shortlist.size() / 2]];
+    return w.strings[shortlist[count / 2]];
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -296,27 +449,34 @@ const std::string &algo_entropy(const words &w, const WordleState &state)
     if (candidates.size() == 1)
         return w.strings[candidates[0]];
 
+    // Histogram over every pattern, only the touched bins are cleared again
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
+    int *pattern_count = arena.alloc<int>(PATTERN_COUNT);
+    int *touched = arena.alloc<int>(std::min<size_t>(PATTERN_COUNT, candidates.size()));
+    std::fill(pattern_count, pattern_count + PATTERN_COUNT, 0);
+
     double max = -1.0;
     int best_idx = candidates[0];
     for (int idx : candidates)
     {
-        const std::string &candidate = w.strings[idx];
+        const char *candidate = w.chars(idx);
 
         double entropy = 0.0;
-        std::unordered_map<std::vector<short>, int, VectorHash> pattern_count;
+        int touchedCount = 0;
 
         // Compute entropy
         for (int idx2 : candidates)
         {
-            const std::string &target = w.strings[idx2];
+            const char *target = w.chars(idx2);
 
-            std::vector<short> pattern(5);
-            std::vector<bool> green_char(5, false);
+            std::array<short, WORD_LEN> pattern = {0};
+            std::array<bool, WORD_LEN> green_char = {false};
 
             // 1 - Green
             // 2 - Grey
             // 3 - Yellow
-            for (int i = 0; i < 5; i++)
+            for (int i = 0; i < WORD_LEN; i++)
             {
                 if (candidate[i] == target[i])
                 {
@@ -325,13 +485,13 @@ const std::string &algo_entropy(const words &w, const WordleState &state)
                 }
             }
 
-            for (int i = 0; i < 5; i++)
+            for (int i = 0; i < WORD_LEN; i++)
             {
                 if (pattern[i] == 1)
                     continue;
 
                 bool found = false;
-                for (int j = 0; j < 5; j++)
+                for (int j = 0; j < WORD_LEN; j++)
                 {
                     if (green_char[j])
                         continue;
@@ -346,12 +506,18 @@ const std::string &algo_entropy(const words &w, const WordleState &state)
                 pattern[i] = found ? 3 : 2;
             }
 
-            pattern_count[pattern]++;
+            int code = 0;
+            for (int i = 0; i < WORD_LEN; i++)
+                code = code * 3 + pattern[i] - 1;
+
+            if (pattern_count[code]++ == 0)
+                touched[touchedCount++] = code;
         }
 
-        for (auto &kv : pattern_count)
+        for (int t = 0; t < touchedCount; ++t)
         {
-            double p = kv.second / (double)candidates.size();
+            double p = pattern_count[touched[t]] / (double)candidates.size();
+            pattern_count[touched[t]] = 0;
 
             if (p > 0.0)
                 entropy += -p * std::log2(p);
@@ -366,10 +532,104 @@ const std::string &algo_entropy(const words &w, const WordleState &state)
     return w.strings[best_idx];
 }
 
+/**
+ * Every metric of the pattern distribution produced by one guess, from one histogram.
+ *
+ * @param row Pattern table row of the guess
+ * @param cols Table columns of the candidates, gathered once per call
+ * @param n Candidate count
+ *
+ * @note Large sets count into 4 interleaved sub-histograms so consecutive
+ *       increments never wait on each other, then merge them in one vectorizable
+ *       pass. Bins are summed in order, so klogk matches a single histogram
+ */
+inline GuessScore scoreGuess(const pattern_t *row, const uint32_t *cols, size_t n, const double *klogk)
+{
+    // Sub-histograms only while all 4 fit in L1
+    constexpr bool SPLIT = PATTERN_COUNT <= 256;
+    constexpr int BINS = SPLIT ? 256 : PATTERN_COUNT;
+    alignas(64) int sub[SPLIT ? 4 : 1][BINS];
+    int *pattern_count = sub[0];
+    TRACE_COUNT(tableBytes, n * sizeof(pattern_t));
+
+    if (n < 64 || !SPLIT)
+    {
+        std::fill(pattern_count, pattern_count + PATTERN_COUNT, 0);
+        for (size_t i = 0; i < n; ++i)
+            ++pattern_count[row[cols[i]]];
+    }
+    else
+    {
+        std::memset(sub, 0, sizeof(sub));
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            ++sub[0][row[cols[i]]];
+            ++sub[SPLIT][row[cols[i + 1]]];
+            ++sub[2 * SPLIT][row[cols[i + 2]]];
+            ++sub[3 * SPLIT][row[cols[i + 3]]];
+        }
+        for (; i < n; ++i)
+            ++sub[0][row[cols[i]]];
+
+        for (int p = 0; p < BINS; ++p)
+            sub[0][p] += sub[SPLIT][p] + sub[2 * SPLIT][p] + sub[3 * SPLIT][p];
+    }
+
+    GuessScore score;
+    for (int p = 0; p < PATTERN_COUNT; ++p)
+    {
+        int k = pattern_count[p];
+        if (k)
+        {
+            score.klogk += klogk[k];
+            score.sumSquares += (uint64_t)k * k;
+            score.largest = std::max(score.largest, k);
+            score.parts++;
+        }
+    }
+    score.solves = pattern_count[ALL_GREEN] != 0;
+    return score;
+}
+
+/**
+ * Order two guesses by the policy's metrics, first difference wins.
+ *
+ * @return < 0 if a is better, > 0 if b is better, 0 if tied on every metric
+ */
+inline int compareScores(const GuessScore &a, const GuessScore &b, const ScorePolicy &policy)
+{
+    for (Metric metric : policy.order)
+    {
+        switch (metric)
+        {
+        case Metric::ENTROPY:
+            // Same N, so lower sum k*log2(k) = higher entropy
+            if (a.klogk != b.klogk)
+                return a.klogk < b.klogk ? -1 : 1;
+            break;
+        case Metric::EXPECTED_SIZE:
+            if (a.sumSquares != b.sumSquares)
+                return a.sumSquares < b.sumSquares ? -1 : 1;
+            break;
+        case Metric::MINIMAX:
+            if (a.largest != b.largest)
+                return a.largest < b.largest ? -1 : 1;
+            break;
+        case Metric::MOST_PARTS:
+            if (a.parts != b.parts)
+                return a.parts > b.parts ? -1 : 1;
+            break;
+        case Metric::NONE:
+            return 0;
+        }
+    }
+    return 0;
+}
+
 /**
  *
  * @warning REQUIRES precomputing entropy
- * @warning WORD_LEN is limited to 5 because uint8_t is used when precomputing
  */
 const std::string &algo_entropy_fast(const words &w, const WordleState &state)
 {
@@ -385,39 +645,538 @@ const std::string &algo_entropy_fast(const words &w, const WordleState &state)
 
     const auto &klogk = w.e->klogk;
     const auto &ptable = w.e->pattern_table;
-    const int wordCount = w.strings.size();
-    const double log2N = std::log2((double)candidates.size());
+    const size_t answerCount = w.answers.size();
+    const size_t n = candidates.size();
+    const double log2N = std::log2((double)n);
+
+    // Gather candidate columns once, candidates are always answers
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
+    uint32_t *cols = arena.alloc<uint32_t>(n);
+    for (size_t i = 0; i < n; ++i)
+        cols[i] = w.e->column[candidates[i]];
 
     double best_entropy = -1.0;
     int best_idx = candidates[0];
-    std::array<int, 243> pattern_count; // Assuming 5 chars
     for (int guess_idx : candidates)
     {
-        pattern_count.fill(0);
+        // compute S = sum_k (k * log2(k)) via table, then H = log2N - S/N
+        GuessScore score = scoreGuess(ptable + guess_idx * answerCount, cols, n, klogk);
+        double entropy = log2N - (score.klogk / (double)n);
 
-        const int base = guess_idx * wordCount;
-        // count patterns
-        for (int target_idx : candidates)
+        if (entropy > best_entropy)
         {
-            uint8_t code = ptable[base + (size_t)target_idx];
-            ++pattern_count[code];
+            best_entropy = entropy;
+            best_idx = guess_idx;
         }
+    }
+    return w.strings[best_idx];
+}
 
-        // compute S = sum_k (k * log2(k)) via table, then H = log2N - S/N
+/**
+ * Like algo_entropy_fast, but every allowed guess is considered, not only candidates.
+ *
+ * Pruning:
+ *  - Stops once a guess reaches log2(min(PATTERN_COUNT, N)), nothing can score higher
+ *  - While counting a guess, S = sum k*log2(k) of the partial histogram only grows,
+ *    so log2N - S/N bounds its final entropy. Once that is below the best
+ *    entropy so far the guess is dropped
+ *
+ * @note Candidates are scored first and only a strictly better guess replaces
+ *       the best, so ties go to a guess that can still win this turn
+ * @warning REQUIRES precomputing entropy
+ */
+const std::string &algo_entropy_full(const words &w, const WordleState &state)
+{
+    if (w.e == nullptr)
+    {
+        std::cerr << "ERROR: Entropy precomputation missing";
+        exit(1);
+    }
+
+    const auto &candidates = state.candidates;
+    if (candidates.size() <= 2)
+        return w.strings[candidates[0]];
+
+    const double *klogk = w.e->klogk;
+    const pattern_t *ptable = w.e->pattern_table;
+    const size_t answerCount = w.answers.size();
+    const size_t n = candidates.size();
+    const double log2N = std::log2((double)n);
+    const double maxEntropy = std::log2((double)std::min<size_t>(PATTERN_COUNT, n));
+    constexpr double EPS = 1e-9;
+
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
+    uint32_t *cols = arena.alloc<uint32_t>(n);
+    uint8_t *isCandidate = arena.alloc<uint8_t>(w.strings.size());
+    std::memset(isCandidate, 0, w.strings.size());
+    for (size_t i = 0; i < n; ++i)
+    {
+        cols[i] = w.e->column[candidates[i]];
+        isCandidate[candidates[i]] = 1;
+    }
+
+    double best_entropy = -1.0;
+    int best_idx = candidates[0];
+
+    auto score = [&](int guess_idx)
+    {
+        const pattern_t *row = ptable + guess_idx * answerCount;
+        std::array<int, PATTERN_COUNT> pattern_count = {0};
         double S = 0.0;
-        for (int p = 0; p < 243; ++p)
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            int k = ++pattern_count[row[cols[i]]];
+            S += klogk[k] - klogk[k - 1];
+
+            // Partial histogram bound, with EPS of slack for the running sum's rounding
+            if ((i & 63) == 63 && log2N - S / (double)n < best_entropy - EPS)
+            {
+                TRACE_COUNT(tableBytes, (i + 1) * sizeof(pattern_t));
+                return;
+            }
+        }
+        TRACE_COUNT(tableBytes, n * sizeof(pattern_t));
+
+        // Same bin order as scoreGuess, so scores match algo_entropy_fast
+        S = 0.0;
+        for (int p = 0; p < PATTERN_COUNT; ++p)
         {
             int k = pattern_count[p];
             if (k)
                 S += klogk[k];
         }
-        double entropy = log2N - (S / (double)candidates.size());
+        double entropy = log2N - (S / (double)n);
 
         if (entropy > best_entropy)
         {
             best_entropy = entropy;
             best_idx = guess_idx;
         }
+    };
+
+    for (int guess_idx : candidates)
+    {
+        score(guess_idx);
+        if (best_entropy >= maxEntropy - EPS)
+            return w.strings[best_idx];
     }
+
+    forEachGuess(
+        w, state,
+        [&](int guess_idx)
+        {
+            if (!isCandidate[guess_idx])
+                score(guess_idx);
+            return best_entropy < maxEntropy - EPS;
+        });
     return w.strings[best_idx];
-}
\ No newline at end of file
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                     Policy Based Scoring
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Pick the best guess under a ScorePolicy. Each guess costs one histogram no
+ * matter how many metrics the policy combines.
+ *
+ * @warning REQUIRES precomputing entropy
+ */
+struct ScoredAlgorithm
+{
+    ScorePolicy policy;
+
+    const std::string &operator()(const words &w, const WordleState &state) const
+    {
+        if (w.e == nullptr)
+        {
+            std::cerr << "ERROR: Entropy precomputation missing";
+            exit(1);
+        }
+
+        const auto &candidates = state.candidates;
+        if (candidates.size() <= 2)
+            return w.strings[candidates[0]];
+
+        const pattern_t *ptable = w.e->pattern_table;
+        const size_t answerCount = w.answers.size();
+        const size_t n = candidates.size();
+
+        ScratchArena &arena = scratch();
+        ArenaScope scope(arena);
+        uint32_t *cols = arena.alloc<uint32_t>(n);
+        for (size_t i = 0; i < n; ++i)
+            cols[i] = w.e->column[candidates[i]];
+
+        GuessScore best;
+        int best_idx = -1;
+        auto consider = [&](int guess_idx)
+        {
+            GuessScore score = scoreGuess(ptable + guess_idx * answerCount, cols, n, w.e->klogk);
+
+            int order = best_idx == -1 ? -1 : compareScores(score, best, policy);
+            if (order < 0 || (order == 0 && score.solves && !best.solves))
+            {
+                best = score;
+                best_idx = guess_idx;
+            }
+        };
+
+        if (policy.allGuesses)
+        {
+            forEachGuess(
+                w, state,
+                [&](int guess_idx)
+                {
+                    consider(guess_idx);
+                    return true;
+                });
+        }
+        else
+        {
+            for (int guess_idx : candidates)
+                consider(guess_idx);
+        }
+        return w.strings[best_idx];
+    }
+};
+
+// Fewest candidates left in the worst case, then on average
+const std::string &algo_minimax(const words &w, const WordleState &state)
+{
+    static const ScoredAlgorithm algorithm = {{{Metric::MINIMAX, Metric::EXPECTED_SIZE}, true}};
+    return algorithm(w, state);
+}
+
+// Fewest candidates left on average
+const std::string &algo_expected(const words &w, const WordleState &state)
+{
+    static const ScoredAlgorithm algorithm = {{{Metric::EXPECTED_SIZE, Metric::ENTROPY}, true}};
+    return algorithm(w, state);
+}
+
+// Most distinct outcomes, then highest entropy
+const std::string &algo_mostparts(const words &w, const WordleState &state)
+{
+    static const ScoredAlgorithm algorithm = {{{Metric::MOST_PARTS, Metric::ENTROPY}, true}};
+    return algorithm(w, state);
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                     Batched Suggestions
+// -------------------------------------------------------------------------------------------------
+
+// suggestBatch's pick for a state no word is left for
+constexpr uint32_t NO_SUGGESTION = UINT32_MAX;
+
+/**
+ * ScoredAlgorithm{policy} for many states at once, e.g. every session waiting on
+ * a server. States with the same candidates are scored once, and each pattern
+ * table row is read once for every set that scores that guess.
+ *
+ * @param guesses Word index of the pick for states[i], same as calling
+ *        ScoredAlgorithm{policy} on it. {ENTROPY} without allGuesses picks
+ *        like algo_entropy_fast. NO_SUGGESTION for a state without candidates,
+ *        the other states are still answered
+ * @warning REQUIRES precomputing entropy
+ */
+void suggestBatch(const words &w, const std::vector<const WordleState *> &states,
+                  const ScorePolicy &policy, std::vector<uint32_t> &guesses)
+{
+    if (w.e == nullptr)
+    {
+        std::cerr << "ERROR: Entropy precomputation missing";
+        exit(1);
+    }
+
+    struct Group
+    {
+        const std::vector<int> *candidates;
+        const std::vector<int> *pool; // Hard mode guess pool with allGuesses, nullptr otherwise
+        uint32_t *cols;
+        GuessScore best;
+        int best_idx = -1;
+    };
+
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
+    std::vector<Group> groups;
+    std::vector<int> groupOf(states.size(), -1);
+    std::unordered_map<uint64_t, std::vector<int>> byHash;
+
+    guesses.resize(states.size());
+    for (size_t i = 0; i < states.size(); ++i)
+    {
+        const auto &candidates = states[i]->candidates;
+        if (candidates.empty())
+        {
+            guesses[i] = NO_SUGGESTION;
+            continue;
+        }
+        if (candidates.size() <= 2)
+        {
+            guesses[i] = candidates[0];
+            continue;
+        }
+
+        const std::vector<int> *pool = nullptr;
+        if (policy.allGuesses && states[i]->hardMode && !states[i]->guessPool.empty())
+            pool = &states[i]->guessPool;
+
+        // Same hash is not enough, compare the sets too
+        auto &bucket = byHash[stateHash(*states[i], false)];
+        for (int g : bucket)
+            if (*groups[g].candidates == candidates &&
+                (groups[g].pool == pool || (groups[g].pool && pool && *groups[g].pool == *pool)))
+                groupOf[i] = g;
+
+        if (groupOf[i] == -1)
+        {
+            groupOf[i] = groups.size();
+            bucket.push_back(groups.size());
+
+            uint32_t *cols = arena.alloc<uint32_t>(candidates.size());
+            for (size_t k = 0; k < candidates.size(); ++k)
+                cols[k] = w.e->column[candidates[k]];
+            groups.push_back({&candidates, pool, cols, GuessScore(), -1});
+        }
+    }
+
+    const pattern_t *ptable = w.e->pattern_table;
+    const size_t answerCount = w.answers.size();
+    auto consider = [&](Group &group, const pattern_t *row, int guess_idx)
+    {
+        GuessScore score = scoreGuess(row, group.cols, group.candidates->size(), w.e->klogk);
+
+        int order = group.best_idx == -1 ? -1 : compareScores(score, group.best, policy);
+        if (order < 0 || (order == 0 && score.solves && !group.best.solves))
+        {
+            group.best = score;
+            group.best_idx = guess_idx;
+        }
+    };
+
+    if (policy.allGuesses)
+    {
+        // Every set scores every row, so all sets share one pass over the table.
+        // Hard mode sets step through their sorted pool alongside
+        size_t *next = arena.alloc<size_t>(groups.size());
+        std::fill(next, next + groups.size(), 0);
+        for (int guess_idx = 0; guess_idx < (int)w.strings.size(); ++guess_idx)
+        {
+            const pattern_t *row = ptable + guess_idx * answerCount;
+            for (size_t g = 0; g < groups.size(); ++g)
+            {
+                Group &group = groups[g];
+                if (group.pool)
+                {
+                    if (next[g] == group.pool->size() || (*group.pool)[next[g]] != guess_idx)
+                        continue;
+                    ++next[g];
+                }
+                consider(group, row, guess_idx);
+            }
+        }
+    }
+    else
+    {
+        // Sets only score their own candidates: visit (guess, set) pairs in guess
+        // order, so each row is read once and every set sees its guesses ascending
+        size_t workCount = 0;
+        for (const Group &group : groups)
+            workCount += group.candidates->size();
+
+        std::pair<int, int> *work = arena.alloc<std::pair<int, int>>(workCount);
+        size_t n = 0;
+        for (size_t g = 0; g < groups.size(); ++g)
+            for (int guess_idx : *groups[g].candidates)
+                work[n++] = {guess_idx, (int)g};
+        std::sort(work, work + workCount);
+
+        for (size_t k = 0; k < workCount; ++k)
+            consider(groups[work[k].second], ptable + work[k].first * answerCount, work[k].first);
+    }
+
+    for (size_t i = 0; i < states.size(); ++i)
+        if (groupOf[i] != -1)
+            guesses[i] = groups[groupOf[i]].best_idx;
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                      Transposition Cache
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Canonical hash of a state. Candidates are always sorted, so equal sets hash equal.
+ *
+ * @param constraints Also mix in green/yellow/grey/letter counts, needed for
+ *        algorithms that read more than the candidates
+ */
+uint64_t stateHash(const WordleState &state, bool constraints)
+{
+    auto mix = [](uint64_t h, uint64_t v)
+    {
+        // splitmix64 finalizer over the running hash
+        h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        return h ^ (h >> 31);
+    };
+
+    uint64_t hash = mix(0, state.candidates.size());
+    for (int idx : state.candidates)
+        hash = mix(hash, idx);
+
+    if (constraints)
+    {
+        for (int i = 0; i < WORD_LEN; ++i)
+        {
+            hash = mix(hash, ((uint64_t)state.yellow[i] << 9) | ((uint64_t)(uint8_t)state.green[i] << 1) | state.solvedLetters[i]);
+        }
+        // Hard mode changes which guesses an algorithm may pick
+        hash = mix(hash, ((uint64_t)state.hardMode << 63) | ((uint64_t)state.grey << 32) | state.requiredCharMask);
+        for (int i = 0; i < 26; ++i)
+            hash = mix(hash, state.maxSameChar[i]);
+    }
+    return hash;
+}
+
+/**
+ * Bounded, lock-free map from state hash to the guess an algorithm picked.
+ *
+ * Direct mapped: every slot packs a 40 bit tag and a 24 bit word index into one
+ * atomic word, so readers never see a torn entry. Colliding inserts overwrite.
+ *
+ * Hits and misses are counted in per-thread stripes, each on its own cache line
+ * away from slots and mask, so lookups never write a line other threads read.
+ */
+struct TranspositionCache
+{
+    static constexpr size_t STRIPES = 16; // Threads beyond this share stripes
+
+    struct alignas(64) Counters
+    {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+
+    std::vector<std::atomic<uint64_t>> slots;
+    uint64_t mask;
+    std::array<Counters, STRIPES> counters;
+
+    /**
+     * @param capacity Slot count, rounded up to a power of two (max 2^24)
+     */
+    TranspositionCache(size_t capacity = 1 << 16)
+    {
+        size_t size = 1;
+        while (size < capacity && size < (1u << 24))
+            size <<= 1;
+        slots = std::vector<std::atomic<uint64_t>>(size);
+        mask = size - 1;
+    }
+
+    static inline uint64_t tag(uint64_t key)
+    {
+        uint64_t t = key >> 24;
+        return t == 0 ? 1 : t; // 0 marks an empty slot
+    }
+
+    bool find(uint64_t key, uint32_t &guess_idx)
+    {
+        uint64_t entry = slots[key & mask].load(std::memory_order_relaxed);
+        Counters &counter = stripe();
+        if ((entry >> 24) == tag(key))
+        {
+            guess_idx = entry & 0xFFFFFF;
+            counter.hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        counter.misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void insert(uint64_t key, uint32_t guess_idx)
+    {
+        slots[key & mask].store((tag(key) << 24) | (guess_idx & 0xFFFFFF), std::memory_order_relaxed);
+    }
+
+    void clear()
+    {
+        for (auto &slot : slots)
+            slot.store(0, std::memory_order_relaxed);
+        for (auto &counter : counters)
+        {
+            counter.hits = 0;
+            counter.misses = 0;
+        }
+    }
+
+    // Calling thread's counters, threads are spread over the stripes as they first look up
+    inline Counters &stripe()
+    {
+        static std::atomic<size_t> threads{0};
+        thread_local const size_t index = threads.fetch_add(1, std::memory_order_relaxed) % STRIPES;
+        return counters[index];
+    }
+
+    uint64_t hits() const
+    {
+        uint64_t total = 0;
+        for (const auto &counter : counters)
+            total += counter.hits.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    uint64_t misses() const
+    {
+        uint64_t total = 0;
+        for (const auto &counter : counters)
+            total += counter.misses.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    void printStats() const
+    {
+        uint64_t h = hits(), m = misses();
+        std::cout << "Transposition cache: " << h << " hits, " << m << " misses";
+        if (h + m)
+            std::cout << " (" << 100.0 * h / (h + m) << " %)";
+        std::cout << "\n";
+    }
+};
+
+/**
+ * Wraps an algo_* function so identical states are only scored once.
+ * Drop-in for runAlgorithm, playSecretWord and friends.
+ *
+ * @note candidatesOnly is only valid for algorithms that read nothing but the
+ *       candidates (algo_entropy_fast, algo_entropy, algo_idx*)
+ */
+template <typename Algo>
+struct CachedAlgorithm
+{
+    Algo algorithm;
+    TranspositionCache *cache = nullptr; // nullptr - Pass through
+    bool candidatesOnly = false;
+
+    const std::string &operator()(const words &w, const WordleState &state) const
+    {
+        if (cache == nullptr || state.candidates.size() <= 2)
+            return algorithm(w, state);
+
+        uint64_t key = stateHash(state, !candidatesOnly);
+        uint32_t guess_idx;
+        if (cache->find(key, guess_idx))
+            return w.strings[guess_idx];
+
+        const std::string &guess = algorithm(w, state);
+        cache->insert(key, &guess - w.strings.data());
+        return guess;
+    }
+};
@@ -0,0 +1,223 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#ifndef TRACK_ALLOCATIONS
+#define TRACK_ALLOCATIONS false // Count heap allocations per thread, build with -DTRACK_ALLOCATIONS=true
+#endif
+
+struct ScratchArena;
+struct ArenaScope;
+ScratchArena &scratch();
+uint64_t heapAllocations();
+
+/**
+ * Per-thread bump allocator for the temporary buffers of the solve loop.
+ *
+ * alloc() hands out 64 byte aligned slices, rewind() releases everything
+ * allocated after a mark at once. Memory is never returned to the heap, so once
+ * the arena has grown to the biggest turn it serves, a turn allocates nothing.
+ *
+ * @note Outgrowing the block never moves live slices: the old block is retired
+ *       and only freed when the arena is rewound to empty
+ */
+struct ScratchArena
+{
+    uint8_t *raw = nullptr;   // As allocated
+    uint8_t *block = nullptr; // raw, 64 byte aligned
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t peak = 0;
+    std::vector<uint8_t *> retired; // raw pointers
+
+    ScratchArena() = default;
+    ScratchArena(const ScratchArena &) = delete;
+    ScratchArena &operator=(const ScratchArena &) = delete;
+
+    ~ScratchArena()
+    {
+        rewind(0);
+        delete[] raw;
+    }
+
+    /**
+     * @return Uninitialized space for n objects of T, valid until rewound past
+     */
+    template <typename T>
+    T *alloc(size_t n)
+    {
+        static_assert(alignof(T) <= 64, "Arena slices are 64 byte aligned");
+
+        size_t start = (used + 63) & ~(size_t)63;
+        size_t end = start + n * sizeof(T);
+        if (end > capacity)
+            grow(end);
+
+        used = end;
+        peak = std::max(peak, used);
+        return (T *)(block + start);
+    }
+
+    // Make sure the next `bytes` of allocations need no heap allocation
+    void reserve(size_t bytes)
+    {
+        if (used + bytes + 64 > capacity)
+            grow(used + bytes + 64);
+    }
+
+    inline size_t mark() const
+    {
+        return used;
+    }
+
+    void rewind(size_t to)
+    {
+        used = to;
+        if (used == 0 && !retired.empty())
+        {
+            for (uint8_t *old : retired)
+                delete[] old;
+            retired.clear();
+        }
+    }
+
+private:
+    void grow(size_t needed)
+    {
+        size_t size = std::max<size_t>(needed * 2, 1 << 16);
+        uint8_t *next = new uint8_t[size + 63]; // No aligned_alloc on MinGW
+
+        // Offsets stay the same, slices below `used` keep living in the old block
+        if (raw)
+            retired.push_back(raw);
+        raw = next;
+        block = (uint8_t *)(((uintptr_t)next + 63) & ~(uintptr_t)63);
+        capacity = size;
+    }
+};
+
+/**
+ * Rewinds the arena to where it was on construction, for the lifetime of one call.
+ */
+struct ArenaScope
+{
+    ScratchArena &arena;
+    size_t start;
+
+    ArenaScope(ScratchArena &arena = scratch()) : arena(arena), start(arena.mark()) {}
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    ~ArenaScope()
+    {
+        arena.rewind(start);
+    }
+};
+
+ScratchArena &scratch()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                     Allocation Tracking
+// -------------------------------------------------------------------------------------------------
+
+#if TRACK_ALLOCATIONS
+thread_local uint64_t allocationCount = 0;
+
+void *trackedAlloc(size_t size)
+{
+    ++allocationCount;
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *trackedAlloc(size_t size, std::align_val_t alignment)
+{
+    ++allocationCount;
+    // aligned_alloc needs a size that is a multiple of the alignment
+    const size_t align = (size_t)alignment;
+    if (void *ptr = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) & ~(align - 1)))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+// Every form goes through the same counter, so new[] / delete[] and
+// over-aligned types never mix with the library's allocator
+void *operator new(size_t size)
+{
+    return trackedAlloc(size);
+}
+
+void *operator new[](size_t size)
+{
+    return trackedAlloc(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    return trackedAlloc(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    return trackedAlloc(size, alignment);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+uint64_t heapAllocations()
+{
+    return allocationCount;
+}
+#else
+// Always 0 unless built with TRACK_ALLOCATIONS
+uint64_t heapAllocations()
+{
+    return 0;
+}
+#endif
@@ -0,0 +1,573 @@
+#include "wordle-tree.cpp"
+
+#ifndef _WIN32
+#include <sched.h>
+#endif
+
+#define BENCH_URL "bench-results.json"
+
+struct BenchOptions;
+struct BenchResult;
+struct BenchSuite;
+bool parseOptions(int argc, char const *argv[], BenchOptions &options);
+bool pinToCpu(int cpu);
+void writeJson(const BenchSuite &suite, const words &w, const std::string &path);
+
+/**
+ * Command line, see printUsage for the flags.
+ */
+struct BenchOptions
+{
+    int repetitions = 5;
+    int warmup = 1;
+    int samples = 2000;    // Games per opener for turn/getCandidates
+    int algoSamples = 32;  // States per opener and size class for algorithms
+    uint64_t seed = 42;
+    int cpu = -1;          // -1 - Not pinned
+    int threads = 0;       // Pattern table build, 0 - All hardware threads
+    bool patternTable = true;
+    bool hugePages = false; // Map the cached pattern table with huge pages
+    std::string filter;    // Only run benchmarks whose name contains this
+    std::string out = BENCH_URL;
+    std::string dictionary = WORD_URL;
+    std::string answers = ANSWER_URL; // "" - Every word is a possible answer
+#if WORD_LEN == 5
+    std::vector<std::string> openers = {"salet", "crane", "adieu"};
+#else
+    std::vector<std::string> openers = {DEFAULT_WORDS.opener};
+#endif
+};
+
+struct BenchResult
+{
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> params;
+    size_t ops = 0;             // Operations per repetition
+    std::vector<double> nsPerOp; // One entry per repetition
+    double meanCandidates = -1; // Average candidate count the operation saw, -1 if n/a
+};
+
+struct BenchSuite
+{
+    BenchOptions options;
+    std::vector<BenchResult> results;
+    uint64_t sink = 0; // Results are folded in so nothing is optimized away
+
+    /**
+     * Time fn() `warmup` times untimed, then once per repetition.
+     *
+     * @param ops Operations one fn() call performs, times are reported per operation
+     */
+    template <typename Fn>
+    void run(const std::string &name, std::vector<std::pair<std::string, std::string>> params,
+             size_t ops, int warmup, int repetitions, Fn fn, double meanCandidates = -1)
+    {
+        runWithSetup(name, std::move(params), ops, warmup, repetitions, [] {}, fn, meanCandidates);
+    }
+
+    /**
+     * As run(), but calls setup() untimed before every fn() call, for inputs fn() consumes.
+     */
+    template <typename Setup, typename Fn>
+    void runWithSetup(const std::string &name, std::vector<std::pair<std::string, std::string>> params,
+             size_t ops, int warmup, int repetitions, Setup setup, Fn fn, double meanCandidates = -1)
+    {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+            return;
+
+        for (int i = 0; i < warmup; ++i)
+        {
+            setup();
+            sink += fn();
+        }
+
+        BenchResult result = {name, std::move(params), ops, {}, meanCandidates};
+        for (int rep = 0; rep < repetitions; ++rep)
+        {
+            setup();
+            auto start = std::chrono::steady_clock::now();
+            sink += fn();
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            result.nsPerOp.push_back(ns / std::max<size_t>(ops, 1));
+        }
+
+        auto sorted = result.nsPerOp;
+        std::sort(sorted.begin(), sorted.end());
+        std::cout << std::left << std::setw(44) << label(result)
+                  << std::right << std::setw(14) << std::fixed << std::setprecision(1) << sorted[sorted.size() / 2]
+                  << " ns/op  (min " << sorted[0] << ", " << ops << " ops)\n";
+        results.push_back(std::move(result));
+    }
+
+    static std::string label(const BenchResult &result)
+    {
+        std::string text = result.name;
+        for (const auto &param : result.params)
+            text += "/" + param.second;
+        return text;
+    }
+};
+
+// -------------------------------------------------------------------------------------------------
+//                                          Fixtures
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Answers to play, shuffled with the suite seed so every run uses the same games.
+ */
+std::vector<int> sampleAnswers(const words &w, size_t count, uint64_t seed)
+{
+    std::vector<int> sample = w.answers;
+    std::mt19937_64 gen(seed);
+    std::shuffle(sample.begin(), sample.end(), gen);
+    sample.resize(std::min(count, sample.size()));
+    return sample;
+}
+
+/**
+ * States right after `guess` was played (candidates not yet filtered).
+ *
+ * @param from States to continue from, fresh games if empty
+ */
+std::vector<WordleState> playTurn(const words &w, const std::vector<int> &answers,
+                                  const std::vector<WordleState> &from, const std::vector<std::string> &guesses, int turn)
+{
+    std::vector<WordleState> states(answers.size());
+    for (size_t i = 0; i < answers.size(); ++i)
+    {
+        if (!from.empty())
+            states[i] = from[i];
+
+        WordleGame game(w.strings[answers[i]], &states[i]);
+        game.currentTurn = turn;
+        game.turn(guesses[i]);
+    }
+    return states;
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                         Benchmarks
+// -------------------------------------------------------------------------------------------------
+
+void benchLoad(BenchSuite &suite)
+{
+    suite.run("load_words", {}, 1, suite.options.warmup, suite.options.repetitions,
+              [&suite]()
+              {
+                  words fresh;
+                  loadWords(fresh, false, suite.options.dictionary, suite.options.answers);
+                  return (uint64_t)fresh.strings.size();
+              });
+}
+
+void benchPatternTable(BenchSuite &suite)
+{
+    if (!suite.options.patternTable)
+        return;
+
+    words fresh;
+    loadWords(fresh, false, suite.options.dictionary, suite.options.answers);
+
+    std::vector<int> threadCounts = {1};
+    int all = suite.options.threads > 0 ? suite.options.threads : defaultThreadCount();
+    if (all != 1)
+        threadCounts.push_back(all);
+
+    // A build takes seconds, so no warm-up and a single repetition
+    for (int threads : threadCounts)
+    {
+        suite.run("pattern_table", {{"threads", std::to_string(threads)}}, fresh.strings.size(), 0, 1,
+                  [&fresh, threads]()
+                  {
+                      buildPatternTable(fresh, threads);
+                      return (uint64_t)fresh.e->pattern_table[0];
+                  });
+    }
+}
+
+void benchTurn(BenchSuite &suite, const words &w, const std::string &opener, const std::vector<int> &answers)
+{
+    WordleState state;
+    suite.run("game_turn", {{"opener", opener}}, answers.size(), suite.options.warmup, suite.options.repetitions,
+              [&]()
+              {
+                  uint64_t sum = 0;
+                  for (int answer_idx : answers)
+                  {
+                      state.reset();
+                      WordleGame game(w.strings[answer_idx], &state);
+                      game.turn(opener);
+                      sum += game.pattern;
+                  }
+                  return sum;
+              });
+}
+
+/**
+ * Every filter on turn 1 (from all answers) and turn 2 (pruning turn 1 candidates).
+ */
+void benchCandidates(BenchSuite &suite, const words &w, const std::string &opener, const std::vector<int> &answers)
+{
+    using Filter = void (*)(const words &, WordleState &);
+    std::vector<std::pair<std::string, Filter>> filters = {
+        {"default", getCandidates},
+        {"scan", getCandidatesScan}, // Baseline for the faster filters
+        {"bitset", getCandidatesBitset},
+        {"pattern", getCandidatesPattern}};
+
+    // Turn 2 replays the entropy suggestion, as a game would
+    std::vector<std::string> openers(answers.size(), opener);
+    std::vector<WordleState> turn1 = playTurn(w, answers, {}, openers, 1);
+    std::vector<WordleState> filtered = turn1;
+    std::vector<std::string> second(answers.size());
+    for (size_t i = 0; i < answers.size(); ++i)
+    {
+        getCandidates(w, filtered[i]);
+        second[i] = w.e ? algo_entropy_fast(w, filtered[i]) : algo_idxmiddle(w, filtered[i]);
+    }
+    std::vector<WordleState> turn2 = playTurn(w, answers, filtered, second, 2);
+
+    for (int turn = 1; turn <= 2; ++turn)
+    {
+        const auto &prepared = turn == 1 ? turn1 : turn2;
+        for (const auto &[name, filter] : filters)
+        {
+            // Filters prune in place, so each repetition starts from a fresh copy made untimed
+            std::vector<WordleState> pool;
+
+            double candidatesIn = 0;
+            for (const auto &s : prepared)
+                candidatesIn += s.candidates.empty() ? w.answers.size() : s.candidates.size();
+            candidatesIn /= prepared.size();
+
+            suite.runWithSetup("get_candidates/" + name, {{"opener", opener}, {"turn", std::to_string(turn)}},
+                               prepared.size(), suite.options.warmup, suite.options.repetitions,
+                               [&]() { pool = prepared; },
+                               [&, filter = filter]()
+                               {
+                                   uint64_t sum = 0;
+                                   for (auto &state : pool)
+                                   {
+                                       filter(w, state);
+                                       sum += state.candidates.size();
+                                   }
+                                   return sum;
+                               },
+                               candidatesIn);
+        }
+    }
+}
+
+/**
+ * Every algorithm on real turn 2 states, grouped by candidate count:
+ * small <= 16 < medium <= 256 < large.
+ */
+void benchAlgorithms(BenchSuite &suite, const words &w, const std::string &opener, const std::vector<int> &answers)
+{
+    using Algorithm = const std::string &(*)(const words &, const WordleState &);
+    std::vector<std::pair<std::string, Algorithm>> algorithms = {
+        {"idxmiddle", algo_idxmiddle},
+        {"normal", algo_normal},
+        {"test1", algo_test1},
+        {"entropy", algo_entropy}};
+    if (w.e != nullptr)
+    {
+        algorithms.insert(algorithms.end(), {{"entropy_fast", algo_entropy_fast},
+                                             {"entropy_full", algo_entropy_full},
+                                             {"minimax", algo_minimax},
+                                             {"expected", algo_expected},
+                                             {"mostparts", algo_mostparts}});
+    }
+
+    std::vector<std::string> openers(answers.size(), opener);
+    std::vector<WordleState> states = playTurn(w, answers, {}, openers, 1);
+
+    std::array<std::vector<WordleState>, 3> classes;
+    const std::array<const char *, 3> classNames = {"small", "medium", "large"};
+    for (auto &state : states)
+    {
+        getCandidates(w, state);
+        size_t n = state.candidates.size();
+        int c = n <= 16 ? 0 : n <= 256 ? 1 : 2;
+        if (classes[c].size() < (size_t)suite.options.algoSamples)
+            classes[c].push_back(state);
+    }
+
+    for (const auto &[name, algorithm] : algorithms)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const auto &group = classes[c];
+            if (group.empty())
+                continue;
+
+            double candidates = 0;
+            for (const auto &s : group)
+                candidates += s.candidates.size();
+            candidates /= group.size();
+
+            suite.run("algo/" + name, {{"opener", opener}, {"size", classNames[c]}},
+                      group.size(), suite.options.warmup, suite.options.repetitions,
+                      [&, algorithm = algorithm]()
+                      {
+                          uint64_t sum = 0;
+                          for (const auto &s : group)
+                              sum += &algorithm(w, s) - w.strings.data();
+                          return sum;
+                      },
+                      candidates);
+        }
+    }
+}
+
+/**
+ * Every sampled game asking for its second guess at once, answered one state at a
+ * time and through suggestBatch. Picks are checked to match before timing.
+ */
+void benchBatch(BenchSuite &suite, const words &w, const std::string &opener, const std::vector<int> &answers)
+{
+    if (w.e == nullptr)
+        return;
+
+    std::vector<std::string> openers(answers.size(), opener);
+    std::vector<WordleState> states = playTurn(w, answers, {}, openers, 1);
+    for (auto &state : states)
+        getCandidates(w, state);
+
+    // Scoring every guess costs ~100x more per state, so fewer states
+    const std::vector<std::pair<std::string, ScorePolicy>> policies = {
+        {"entropy", {{Metric::ENTROPY}, false}},
+        {"minimax", {{Metric::MINIMAX, Metric::EXPECTED_SIZE}, true}}};
+
+    for (const auto &[name, policy] : policies)
+    {
+        size_t count = policy.allGuesses ? std::min<size_t>(states.size(), suite.options.algoSamples) : states.size();
+        std::vector<const WordleState *> batch;
+        for (size_t i = 0; i < count; ++i)
+            batch.push_back(&states[i]);
+
+        const ScoredAlgorithm single = {policy};
+        std::vector<uint32_t> guesses;
+        suggestBatch(w, batch, policy, guesses);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (&single(w, *batch[i]) - w.strings.data() != guesses[i])
+            {
+                std::cerr << "suggestBatch disagrees with ScoredAlgorithm on state " << i << "\n";
+                exit(1);
+            }
+        }
+
+        suite.run("batch/" + name + "/per_call", {{"opener", opener}}, count, suite.options.warmup, suite.options.repetitions,
+                  [&]()
+                  {
+                      uint64_t sum = 0;
+                      for (const WordleState *state : batch)
+                          sum += &single(w, *state) - w.strings.data();
+                      return sum;
+                  });
+
+        suite.run("batch/" + name + "/grouped", {{"opener", opener}}, count, suite.options.warmup, suite.options.repetitions,
+                  [&]()
+                  {
+                      suggestBatch(w, batch, policy, guesses);
+                      return std::accumulate(guesses.begin(), guesses.end(), (uint64_t)0);
+                  });
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                       Setup and Output
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Pin the calling thread to one logical CPU.
+ *
+ * @return false if the OS refused
+ */
+bool pinToCpu(int cpu)
+{
+#ifdef _WIN32
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#endif
+}
+
+void printUsage()
+{
+    std::string openers;
+    for (const auto &opener : BenchOptions().openers)
+        openers += (openers.empty() ? "" : ",") + opener;
+
+    std::cout << "Usage: wordle-bench [options]\n"
+              << "  --reps N          Timed repetitions per benchmark (5)\n"
+              << "  --warmup N        Untimed runs before timing (1)\n"
+              << "  --samples N       Games per opener for turn/candidate benchmarks (2000)\n"
+              << "  --algo-samples N  States per opener and size class for algorithms (32)\n"
+              << "  --seed N          Seed for picking games (42)\n"
+              << "  --cpu N           Pin to logical CPU N after the pattern table build\n"
+              << "  --threads N       Threads for the pattern table build, 0 - all (0)\n"
+              << "  --openers a,b     First guesses (" << openers << ")\n"
+              << "  --filter TEXT     Only run benchmarks whose name contains TEXT\n"
+              << "  --no-table        Skip the pattern table build benchmark\n"
+              << "  --huge-pages      Back the cached pattern table with huge pages\n"
+              << "  --words PATH      Dictionary (" << WORD_URL << ")\n"
+              << "  --answers PATH    Answer list, every word if not set (" << ANSWER_URL << ")\n"
+              << "  --out PATH        JSON results (" << BENCH_URL << ")\n";
+}
+
+bool parseOptions(int argc, char const *argv[], BenchOptions &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        auto value = [&]()
+        {
+            return std::string(argv[++i]);
+        };
+
+        if (arg == "--no-table")
+            options.patternTable = false;
+        else if (arg == "--huge-pages")
+            options.hugePages = true;
+        else if (!hasValue)
+            return false;
+        else if (arg == "--reps")
+            options.repetitions = std::max(1, std::stoi(value()));
+        else if (arg == "--warmup")
+            options.warmup = std::max(0, std::stoi(value()));
+        else if (arg == "--samples")
+            options.samples = std::max(1, std::stoi(value()));
+        else if (arg == "--algo-samples")
+            options.algoSamples = std::max(1, std::stoi(value()));
+        else if (arg == "--seed")
+            options.seed = std::stoull(value());
+        else if (arg == "--cpu")
+            options.cpu = std::stoi(value());
+        else if (arg == "--threads")
+            options.threads = std::stoi(value());
+        else if (arg == "--filter")
+            options.filter = value();
+        else if (arg == "--out")
+            options.out = value();
+        else if (arg == "--words")
+            options.dictionary = value();
+        else if (arg == "--answers")
+            options.answers = value();
+        else if (arg == "--openers")
+        {
+            options.openers.clear();
+            std::stringstream list(value());
+            std::string opener;
+            while (std::getline(list, opener, ','))
+                options.openers.push_back(opener);
+        }
+        else
+            return false;
+    }
+    return true;
+}
+
+void writeJson(const BenchSuite &suite, const words &w, const std::string &path)
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "Error: Could not write " << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const auto &options = suite.options;
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n  \"context\": {\n"
+        << "    \"timestamp\": " << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() << ",\n"
+        << "    \"compiler\": \"" << __VERSION__ << "\",\n"
+        << "    \"word_len\": " << WORD_LEN << ",\n"
+        << "    \"words\": " << w.strings.size() << ",\n"
+        << "    \"answers\": " << w.answers.size() << ",\n"
+        << "    \"hardware_threads\": " << defaultThreadCount() << ",\n"
+        << "    \"cpu\": " << options.cpu << ",\n"
+        << "    \"seed\": " << options.seed << ",\n"
+        << "    \"repetitions\": " << options.repetitions << ",\n"
+        << "    \"warmup\": " << options.warmup << "\n"
+        << "  },\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < suite.results.size(); ++i)
+    {
+        const auto &result = suite.results[i];
+        auto sorted = result.nsPerOp;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+        double variance = 0;
+        for (double ns : sorted)
+            variance += (ns - mean) * (ns - mean);
+        double stddev = std::sqrt(variance / sorted.size());
+
+        out << (i ? "," : "") << "\n    {\"name\": \"" << jsonEscape(result.name) << "\", \"params\": {";
+        for (size_t p = 0; p < result.params.size(); ++p)
+            out << (p ? ", " : "") << "\"" << jsonEscape(result.params[p].first) << "\": \"" << jsonEscape(result.params[p].second) << "\"";
+        out << "}, \"ops\": " << result.ops
+            << ", \"ns_per_op\": {\"min\": " << sorted.front()
+            << ", \"median\": " << sorted[sorted.size() / 2]
+            << ", \"mean\": " << mean
+            << ", \"max\": " << sorted.back()
+            << ", \"stddev\": " << stddev << "}";
+        if (result.meanCandidates >= 0)
+            out << ", \"mean_candidates\": " << result.meanCandidates;
+        out << ", \"runs\": [";
+        for (size_t r = 0; r < result.nsPerOp.size(); ++r)
+            out << (r ? ", " : "") << result.nsPerOp[r];
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char const *argv[])
+{
+    BenchSuite suite;
+    if (!parseOptions(argc, argv, suite.options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Threads inherit the affinity, so the multithreaded table build runs before pinning
+    const auto &options = suite.options;
+    benchPatternTable(suite);
+
+    if (options.cpu >= 0 && !pinToCpu(options.cpu))
+        std::cerr << "Warning: Could not pin to CPU " << options.cpu << std::endl;
+
+    benchLoad(suite);
+
+    words w;
+    loadWords(w, CALCULATE_ENTROPY, options.dictionary, options.answers, options.hugePages);
+
+    for (const auto &opener : options.openers)
+    {
+        if (opener.length() != WORD_LEN || !w.word_index.count(encode(opener)))
+        {
+            std::cerr << opener << " is an invalid word!\n";
+            exit(1);
+        }
+
+        std::vector<int> answers = sampleAnswers(w, options.samples, options.seed);
+        benchTurn(suite, w, opener, answers);
+        benchCandidates(suite, w, opener, answers);
+        benchAlgorithms(suite, w, opener, answers);
+        benchBatch(suite, w, opener, answers);
+    }
+
+    writeJson(suite, w, options.out);
+    std::cout << "Results written to " << options.out << " (checksum " << suite.sink << ")\n";
+
+    // Per scope timings of every benchmark above, TRACE_HOT_PATH builds only
+    if (TRACE_HOT_PATH)
+        flushTrace(TRACE_URL);
+    return 0;
+}
@@ -4,52 +4,397 @@
 #include <array>
 #include <unordered_map>
 #include <bits/stdc++.h>
+#include "wordle-parallel.cpp"
+#include "wordle-mmap.cpp"
+#include "wordle-arena.cpp"
+#include "wordle-trace.cpp"
 
 #define CALCULATE_ENTROPY true
 #define MAX_TURNS 6
-#define WORD_LEN 5
-#define WORD_URL "D:\\Code\\Wordle Solver\\valid-wordle-words.txt"
+#ifndef WORD_LEN
+#define WORD_LEN 5 // Build other lengths with -DWORD_LEN=n
+#endif
+#ifndef WORD_URL
+#define WORD_URL "D:\\Code\\Wordle Solver\\valid-wordle-words.txt" // The CMake build points this at the in-tree list
+#endif
+#ifndef ANSWER_URL
+#define ANSWER_URL "" // "" - Every word is a possible answer
+#endif
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
+#define CACHE_URL "pattern-table-" STRINGIFY(WORD_LEN) ".cache" // One per word length, builds never evict each other
+#define CACHE_VERSION 4
+#define BITSET_FILTER true // getCandidates filters with word bitsets
+#define PATTERN_FILTER false // getCandidates keeps candidates giving the observed pattern
+
+static_assert(WORD_LEN >= 2 && WORD_LEN <= 10, "Pattern codes must fit in 16 bits");
+
+// Every feedback pattern is a base 3 number, PATTERN_COUNT - 1 is all green
+constexpr int pow3(int n)
+{
+    return n == 0 ? 1 : 3 * pow3(n - 1);
+}
+constexpr int PATTERN_COUNT = pow3(WORD_LEN);
+constexpr int ALL_GREEN = PATTERN_COUNT - 1;
+
+// Smallest type holding every pattern, uint8_t up to 5 letters
+using pattern_t = std::conditional_t<PATTERN_COUNT <= 256, uint8_t, uint16_t>;
+
+// Default words of each length: first guess, a second probe sharing none of its
+// letters, and the secret of the demo modes. A dictionary may lack them, the
+// programs take the first guess and secret on the command line
+struct LengthWords
+{
+    const char *opener;
+    const char *probe;
+    const char *secret;
+};
+constexpr std::array<LengthWords, 11> LENGTH_WORDS = {{
+    {"", "", ""},
+    {"", "", ""},
+    {"as", "no", "it"},
+    {"tea", "sin", "fox"},
+    {"rate", "lion", "fish"},
+    {"salet", "crony", "fruit"},
+    {"stared", "coming", "planet"},
+    {"rations", "humbled", "kitchen"},
+    {"rationed", "blushing", "elephant"},
+    {"relations", "duckboard", "chocolate"},
+    {"educations", "lumberjack", "basketball"},
+}};
+constexpr bool lengthWordsFit(const LengthWords &words)
+{
+    return std::char_traits<char>::length(words.opener) == WORD_LEN &&
+           std::char_traits<char>::length(words.probe) == WORD_LEN &&
+           std::char_traits<char>::length(words.secret) == WORD_LEN;
+}
+constexpr LengthWords DEFAULT_WORDS = LENGTH_WORDS[WORD_LEN];
+static_assert(lengthWordsFit(DEFAULT_WORDS), "LENGTH_WORDS needs words of WORD_LEN letters");
 
+// Answers are laid out in the pattern table ordered by their feedback against these
+// words, so the candidates left after playing them sit in neighbouring columns
+const std::array<const char *, 2> COLUMN_PROBES = {DEFAULT_WORDS.opener, DEFAULT_WORDS.probe};
+
+struct WordBitset;
+struct WordIndex;
 struct words;
 struct entropy;
 struct WordleState;
 struct WordleGame;
 enum class Status : int;
-void loadWords(words &w, bool comp_entropy = false);
+void loadWords(words &w, bool comp_entropy = false, const std::string &path = WORD_URL, const std::string &answersPath = ANSWER_URL,
+               bool hugePages = false);
+void loadAnswers(words &w, const std::string &path);
+inline pattern_t computePattern(const char *guess, const char *target, const uint8_t *counts);
+inline pattern_t computePattern(const char *guess, const char *target);
+double buildPatternTable(words &w, int threads, const std::function<void(int, int)> &progress = nullptr);
+std::vector<uint32_t> columnOrder(const words &w);
+bool loadPatternCache(words &w, const std::string &path, bool hugePages = false);
+bool savePatternCache(const words &w, const std::string &path);
+uint64_t dictionaryHash(const words &w);
 uint64_t encode(const std::string &str);
 uint32_t bitmask(const std::string &str);
+std::string jsonEscape(const std::string &text);
+void addWord(words &w, const char *word);
+void buildBitsets(words &w);
+void buildLetterFeatures(words &w);
+bool applyFeedback(WordleState &state, const std::string &guess, const std::string &feedback);
 void getCandidates(const words &w, WordleState &state);
+void getCandidatesScan(const words &w, WordleState &state);
+void getCandidatesBitset(const words &w, WordleState &state);
+void getCandidatesPattern(const words &w, WordleState &state);
+void updateCandidateCounts(const words &w, WordleState &state, const int *removed, size_t removedCount);
+inline bool isLegalGuess(const WordleState &state, const char *guess);
+void pruneGuessPool(const words &w, WordleState &state);
+template <typename F>
+inline void forEachGuess(const words &w, const WordleState &state, F f);
+
+/**
+ * One bit per word index. Every bitset of a dictionary has the same length.
+ */
+struct WordBitset
+{
+    std::vector<uint64_t> bits;
+
+    WordBitset() = default;
+    explicit WordBitset(size_t size) : bits((size + 63) / 64, 0) {}
+
+    inline bool empty() const
+    {
+        return bits.empty();
+    }
+    inline void clear()
+    {
+        bits.clear();
+    }
+    // All zero, reuses the existing buffer
+    inline void reset(size_t size)
+    {
+        bits.assign((size + 63) / 64, 0);
+    }
+    // Every index below size set, reuses the existing buffer
+    inline void set_all(size_t size)
+    {
+        bits.assign((size + 63) / 64, ~0ull);
+        if (size & 63)
+            bits.back() = (1ull << (size & 63)) - 1;
+    }
+    inline void set(int idx)
+    {
+        bits[idx >> 6] |= 1ull << (idx & 63);
+    }
+    inline void unset(int idx)
+    {
+        bits[idx >> 6] &= ~(1ull << (idx & 63));
+    }
+    inline bool test(int idx) const
+    {
+        return bits[idx >> 6] & (1ull << (idx & 63));
+    }
+
+    inline void and_with(const WordBitset &other)
+    {
+        TRACE_COUNT(intersections, 1);
+        for (size_t i = 0; i < bits.size(); ++i)
+            bits[i] &= other.bits[i];
+    }
+    inline void andnot_with(const WordBitset &other)
+    {
+        TRACE_COUNT(intersections, 1);
+        for (size_t i = 0; i < bits.size(); ++i)
+            bits[i] &= ~other.bits[i];
+    }
+
+    inline bool any() const
+    {
+        for (uint64_t word : bits)
+            if (word)
+                return true;
+        return false;
+    }
+    inline int count() const
+    {
+        int total = 0;
+        for (uint64_t word : bits)
+            total += __builtin_popcountll(word);
+        return total;
+    }
+
+    /**
+     * @return Index of the n-th set bit (0 based), -1 if there are fewer
+     */
+    int nth(int n) const
+    {
+        for (size_t i = 0; i < bits.size(); ++i)
+        {
+            uint64_t word = bits[i];
+            int c = __builtin_popcountll(word);
+            if (n >= c)
+            {
+                n -= c;
+                continue;
+            }
+            for (; n > 0; --n)
+                word &= word - 1;
+            return i * 64 + __builtin_ctzll(word);
+        }
+        return -1;
+    }
+
+    // Calls fn(idx) for every set bit in ascending order
+    template <typename Fn>
+    inline void forEach(Fn fn) const
+    {
+        for (size_t i = 0; i < bits.size(); ++i)
+        {
+            uint64_t word = bits[i];
+            while (word)
+            {
+                fn((int)(i * 64 + __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+};
+
+/**
+ * Encoded word -> word index. Open addressing over one flat array, so building
+ * it costs a single allocation instead of one node per word.
+ *
+ * @note find() returns a pointer, end() is nullptr
+ */
+struct WordIndex
+{
+    std::vector<std::pair<uint64_t, int>> slots; // second == -1 - empty
+    size_t used = 0;
+
+    // Room for count words at <= 50% load without growing
+    void reserve(size_t count)
+    {
+        size_t size = 16;
+        while (size < count * 2)
+            size <<= 1;
+        if (size > slots.size())
+            rehash(size);
+    }
+
+    // Keeps the first index of a duplicate word, like std::unordered_map
+    void emplace(uint64_t key, int idx)
+    {
+        if ((used + 1) * 2 > slots.size())
+            rehash(std::max<size_t>(16, slots.size() * 2));
+
+        size_t i = probe(key);
+        if (slots[i].second == -1)
+        {
+            slots[i] = {key, idx};
+            used++;
+        }
+    }
+
+    inline const std::pair<uint64_t, int> *find(uint64_t key) const
+    {
+        if (slots.empty())
+            return nullptr;
+        const auto &slot = slots[probe(key)];
+        return slot.second == -1 ? nullptr : &slot;
+    }
+    inline const std::pair<uint64_t, int> *end() const
+    {
+        return nullptr;
+    }
+    inline size_t count(uint64_t key) const
+    {
+        return find(key) != nullptr;
+    }
+    inline size_t size() const
+    {
+        return used;
+    }
 
+private:
+    // Slot holding key, or the empty slot it would go to
+    inline size_t probe(uint64_t key) const
+    {
+        const size_t mask = slots.size() - 1;
+        size_t i = (key * 0x9E3779B97F4A7C15ull) >> 32 & mask;
+        while (slots[i].second != -1 && slots[i].first != key)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    void rehash(size_t size)
+    {
+        std::vector<std::pair<uint64_t, int>> old(size, {0, -1});
+        old.swap(slots);
+        used = 0;
+        for (const auto &slot : old)
+            if (slot.second != -1)
+                emplace(slot.first, slot.second);
+    }
+};
+
+/**
+ * Dictionary, stored as parallel arrays indexed by word index.
+ *
+ * @note strings is only for returning/printing words, hot loops read the packed
+ *       letters and copies so a word costs WORD_LEN contiguous bytes, not a
+ *       pointer chase into a heap allocated std::string
+ */
 struct words
 {
     std::vector<std::string> strings;
+    std::vector<char> letters;   // WORD_LEN letters per word, no terminator
+    std::vector<uint8_t> copies; // WORD_LEN per word, how often the letter at each position occurs in the word
     std::vector<uint32_t> masks;
     std::vector<uint64_t> encoded;
-    std::unordered_map<char, std::vector<int>> inv_index;
+    std::array<std::vector<int>, 26> inv_index; // letter - 'a' -> answers containing it
+
+    std::vector<int> answers; // Possible secret words, as indices into strings
+    WordIndex word_index; // encoded -> word index
+
+    // Bitsets: every answer, then over the whole dictionary words containing a
+    // letter, with a letter at a position, with at least k copies of a letter.
+    // Candidate filters start from answer_bits, the guess pool from every word
+    WordBitset answer_bits;
+    std::array<WordBitset, 26> letter_bits;
+    std::array<std::array<WordBitset, 26>, WORD_LEN> position_bits;
+    std::array<std::array<WordBitset, WORD_LEN + 1>, 26> count_bits;
+
+    // Letter features of every word, one array per position so whole-dictionary
+    // scorers stream them: letter - 'a', 1 if the letter does not occur earlier in
+    // the word, and occurrences of the letter in dictionary order up to here
+    // (every earlier word, plus this one up to and including the position)
+    std::array<std::vector<uint8_t>, WORD_LEN> position_letters;
+    std::array<std::vector<uint8_t>, WORD_LEN> first_letters;
+    std::array<std::vector<uint32_t>, WORD_LEN> letter_runs;
 
     entropy *e = 0;
 
-    ~words()
+    inline const char *chars(int word_idx) const
     {
-        free(e);
+        return letters.data() + (size_t)word_idx * WORD_LEN;
     }
+    inline const uint8_t *copiesOf(int word_idx) const
+    {
+        return copies.data() + (size_t)word_idx * WORD_LEN;
+    }
+
+    ~words();
 };
 
 struct entropy
 {
-    std::vector<uint8_t> pattern_table;
-    std::vector<double> klogk;
+    // Point either into the storage vectors or into a mapped cache file
+    const pattern_t *pattern_table = nullptr;
+    const double *klogk = nullptr;
+
+    // Word index -> table column, answers only
+    std::vector<uint32_t> column;
+
+    std::vector<pattern_t> table_storage;
+    std::vector<double> klogk_storage;
+    MappedFile cache;
 
+    entropy() = default;
+
+    // Guesses x answers, indexed [guess_idx * answers.size() + column[target_idx]]
     entropy(const words &w)
     {
-        klogk = std::vector<double>(w.strings.size() + 1, 0.0);
-        pattern_table = std::vector<uint8_t>(w.strings.size() * w.strings.size());
+        column = columnOrder(w);
+        klogk_storage = std::vector<double>(w.answers.size() + 1, 0.0);
+        table_storage = std::vector<pattern_t>(w.strings.size() * w.answers.size());
+        klogk = klogk_storage.data();
+        pattern_table = table_storage.data();
     }
 };
 
+words::~words()
+{
+    delete e;
+}
+
+/**
+ * On-disk layout of the pattern table cache. The header is followed by klogk
+ * at klogkOffset and the table at tableOffset (page aligned).
+ */
+struct PatternCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t wordLen;
+    uint64_t wordCount;
+    uint64_t answerCount;
+    uint64_t dictHash;
+    uint64_t klogkOffset;
+    uint64_t tableOffset;
+    uint64_t tableSize;
+};
+
 struct WordleState
 {
     std::vector<int> candidates;
+    WordBitset candidate_bits; // Same set as candidates, only filled by getCandidatesBitset
     std::array<bool, WORD_LEN> solvedLetters = {false};
     std::array<char, WORD_LEN> green = {0};
     std::array<uint8_t, 26> maxSameChar = {0};
@@ -57,12 +402,46 @@ struct WordleState
     uint32_t requiredCharMask = 0;
     uint32_t grey = {0};
 
+    // Last guess (encoded) and its base 3 pattern, used by getCandidatesPattern
+    uint64_t lastGuess = 0;
+    pattern_t lastPattern = 0;
+    bool hasPattern = false;
+
+    // Letter counts over the candidates, kept in step by the getCandidates family
+    std::array<std::array<int, 26>, WORD_LEN> positionCharCount = {}; // Candidates with the letter at the position
+    bool hasCounts = false;
+
+    // Hard mode: every guess must keep the greens in place and reuse the revealed letters
+    bool hardMode = false;
+    std::vector<int> guessPool; // Legal guesses in index order, kept by getCandidates in hard mode
+    WordBitset guess_bits;      // Same set as guessPool
+
     WordleState()
     {
         // Roughly biggest list size
         candidates.reserve(8192);
     }
 
+    // Start a new game under the same rules, keeping the buffers so reusing a
+    // state never allocates
+    void reset()
+    {
+        candidates.clear();
+        guessPool.clear();
+        guess_bits.clear();
+        candidate_bits.clear();
+        solvedLetters = {false};
+        green = {0};
+        maxSameChar = {0};
+        yellow = {0};
+        requiredCharMask = 0;
+        grey = 0;
+        lastGuess = 0;
+        lastPattern = 0;
+        hasPattern = false;
+        hasCounts = false;
+    }
+
     inline void set_yellow(int position, uint32_t letterindex)
     {
         yellow[position] |= (1u << letterindex);
@@ -101,120 +480,571 @@ uint64_t encode(const std::string &str)
     return key;
 }
 
+// Text as a JSON string body, for the server replies and the bench results
+std::string jsonEscape(const std::string &text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+            out += code;
+        }
+        else
+            out += c;
+    }
+    return out;
+}
+
+// Append a validated word (WORD_LEN lowercase letters) to every per-word array
+void addWord(words &w, const char *word)
+{
+    std::array<uint8_t, 26> count = {0};
+    uint32_t mask = 0;
+    uint64_t key = 0;
+    for (int i = 0; i < WORD_LEN; ++i)
+    {
+        int c = word[i] - 'a';
+        count[c]++;
+        mask |= 1u << c;
+        key = (key << 5) | (uint64_t)c;
+    }
+
+    w.strings.emplace_back(word, WORD_LEN);
+    w.letters.insert(w.letters.end(), word, word + WORD_LEN);
+    for (int i = 0; i < WORD_LEN; ++i)
+        w.copies.push_back(count[word[i] - 'a']);
+    w.masks.push_back(mask);
+    w.encoded.push_back(key);
+}
+
 // -------------------------------------------------------------------------------------------------
 //                                       Load Dictionary
 // -------------------------------------------------------------------------------------------------
 
-void loadWords(words &w, bool comp_entropy)
+/**
+ * Load the dictionary and build every index over it.
+ *
+ * The file is mapped, not streamed: one memchr-speed pass counts the lines so
+ * every array is sized exactly once, a second validates and parses each word
+ * straight out of the mapping.
+ *
+ * @param path One word of WORD_LEN letters per line, '\n' or "\r\n" terminated.
+ *             Uppercase letters are folded to lowercase
+ * @param answersPath Answer list, see loadAnswers
+ * @param hugePages Back the mapped pattern table with huge pages, see loadPatternCache
+ */
+void loadWords(words &w, bool comp_entropy, const std::string &path, const std::string &answersPath, bool hugePages)
 {
-    std::ifstream wWords(WORD_URL);
+    MappedFile file;
+    if (!file.open(path))
+    {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
 
-    if (!wWords.is_open())
+    const char *begin = (const char *)file.data;
+    const char *end = begin + file.size;
+    const size_t lines = std::count(begin, end, '\n') + (end[-1] != '\n');
+    w.strings.reserve(lines);
+    w.letters.reserve(lines * WORD_LEN);
+    w.copies.reserve(lines * WORD_LEN);
+    w.masks.reserve(lines);
+    w.encoded.reserve(lines);
+
+    char word[WORD_LEN];
+    for (const char *line = begin; line < end;)
     {
-        std::cerr << "Error: Could not open valid-wordle-words.txt" << std::endl;
+        const char *next = (const char *)std::memchr(line, '\n', end - line);
+        if (next == nullptr)
+            next = end;
+
+        size_t length = next - line;
+        if (length > 0 && line[length - 1] == '\r')
+            length--;
+
+        if (length != WORD_LEN)
+        {
+            std::cerr << "Malformed word on: " << std::string(line, length) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        // Fold case, then every letter must be a..z. One check per word, not per letter
+        uint8_t invalid = 0;
+        for (int i = 0; i < WORD_LEN; ++i)
+        {
+            word[i] = line[i] | 0x20;
+            invalid |= (uint8_t)(word[i] - 'a') >= 26;
+        }
+
+        if (invalid)
+        {
+            std::cerr << "Invalid character in: " << std::string(line, length) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        addWord(w, word);
+        line = next + 1;
+    }
+
+    loadAnswers(w, answersPath);
+
+    w.word_index.reserve(w.strings.size());
+    for (int i = 0; i < (int)w.strings.size(); ++i)
+        w.word_index.emplace(w.encoded[i], i);
+
+    // Inverse index over answers, ordered because answers are
+    std::array<size_t, 26> letterAnswers = {0};
+    for (int word_idx : w.answers)
+        for (uint32_t mask = w.masks[word_idx]; mask; mask &= mask - 1)
+            letterAnswers[__builtin_ctz(mask)]++;
+    for (int b = 0; b < 26; ++b)
+        w.inv_index[b].reserve(letterAnswers[b]);
+
+    for (int word_idx : w.answers)
+        for (uint32_t mask = w.masks[word_idx]; mask; mask &= mask - 1)
+            w.inv_index[__builtin_ctz(mask)].push_back(word_idx);
+
+    buildBitsets(w);
+    buildLetterFeatures(w);
+
+    if (comp_entropy && !loadPatternCache(w, CACHE_URL, hugePages))
+    {
+        double ms = buildPatternTable(w, 0);
+        std::cout << "Pattern table: " << w.strings.size() << "x" << w.answers.size()
+                  << " built in " << ms << " ms\n";
+
+        if (!savePatternCache(w, CACHE_URL))
+            std::cerr << "Warning: Could not write " << CACHE_URL << std::endl;
+    }
+}
+
+/**
+ * Fill w.answers from a word list. Answers missing from the guess list are added to it.
+ *
+ * @param path Answer list, "" makes every word a possible answer
+ */
+void loadAnswers(words &w, const std::string &path)
+{
+    w.answers.clear();
+
+    if (path.empty())
+    {
+        w.answers.resize(w.strings.size());
+        std::iota(w.answers.begin(), w.answers.end(), 0);
+        return;
+    }
+
+    std::ifstream wAnswers(path);
+    if (!wAnswers.is_open())
+    {
+        std::cerr << "Error: Could not open " << path << std::endl;
         exit(EXIT_FAILURE);
     }
 
-    std::string currentLine;
-    size_t line = 0;
-    while (std::getline(wWords, currentLine))
+    std::unordered_map<std::string, int> lookup;
+    lookup.reserve(w.strings.size());
+    for (int i = 0; i < (int)w.strings.size(); ++i)
+        lookup.emplace(w.strings[i], i);
+
+    std::string currentLine, word(WORD_LEN, ' ');
+    while (std::getline(wAnswers, currentLine))
     {
+        if (!currentLine.empty() && currentLine.back() == '\r')
+            currentLine.pop_back();
+
         if (currentLine.length() != WORD_LEN)
         {
-            std::cerr << "Malformed word on: " << currentLine << std::endl;
+            std::cerr << "Malformed answer on: " << currentLine << std::endl;
             exit(EXIT_FAILURE);
         }
 
-        for (size_t i = 0; i < WORD_LEN; ++i)
+        // Same folding and check as loadWords
+        uint8_t invalid = 0;
+        for (int i = 0; i < WORD_LEN; ++i)
         {
-            if (!isalpha(currentLine[i]))
-            {
-                std::cerr << "Invalid character in: " << currentLine << std::endl;
-                exit(EXIT_FAILURE);
-            }
+            word[i] = currentLine[i] | 0x20;
+            invalid |= (uint8_t)(word[i] - 'a') >= 26;
         }
 
-        // Log word into struct
-        uint32_t mask = bitmask(currentLine);
-        w.strings.push_back(currentLine);
-        w.masks.push_back(mask);
-        w.encoded.push_back(encode(currentLine));
-        for (int b = 0; b < 26; ++b)
-            if (mask & (1u << b))
-                w.inv_index['a' + b].push_back(line);
+        if (invalid)
+        {
+            std::cerr << "Invalid character in: " << currentLine << std::endl;
+            exit(EXIT_FAILURE);
+        }
 
-        line++;
+        auto it = lookup.find(word);
+        if (it == lookup.end())
+        {
+            it = lookup.emplace(word, (int)w.strings.size()).first;
+            addWord(w, word.c_str());
+        }
+        w.answers.push_back(it->second);
     }
 
-    // Order inverse index
-    for (auto &kv : w.inv_index)
-        std::sort(kv.second.begin(), kv.second.end());
+    // Skip duplicates
+    std::sort(w.answers.begin(), w.answers.end());
+    w.answers.erase(std::unique(w.answers.begin(), w.answers.end()), w.answers.end());
+}
 
-    if (comp_entropy)
+void buildBitsets(words &w)
+{
+    const size_t size = w.strings.size();
+    w.answer_bits = WordBitset(size);
+    for (int c = 0; c < 26; ++c)
     {
-        w.e = new entropy(w);
+        w.letter_bits[c] = WordBitset(size);
+        for (int pos = 0; pos < WORD_LEN; ++pos)
+            w.position_bits[pos][c] = WordBitset(size);
+        for (int k = 0; k <= WORD_LEN; ++k)
+            w.count_bits[c][k] = WordBitset(size);
+    }
 
-        const int wordCount = w.strings.size();
+    for (int word_idx : w.answers)
+        w.answer_bits.set(word_idx);
+
+    for (int word_idx = 0; word_idx < (int)size; ++word_idx)
+    {
+        const char *word = w.chars(word_idx);
+        const uint8_t *copies = w.copiesOf(word_idx);
 
-        // Precompute klogk
-        auto &klogk = w.e->klogk;
-        for (int i = 1; i <= wordCount; ++i)
+        for (int pos = 0; pos < WORD_LEN; ++pos)
         {
-            // klokgk[0] = 0.0
-            klogk[i] = (double)i * std::log2((double)i);
+            int c = word[pos] - 'a';
+            w.position_bits[pos][c].set(word_idx);
+            w.letter_bits[c].set(word_idx);
+            for (int k = 0; k <= copies[pos]; ++k)
+                w.count_bits[c][k].set(word_idx);
         }
+    }
+}
+
+void buildLetterFeatures(words &w)
+{
+    const size_t size = w.strings.size();
+    for (int pos = 0; pos < WORD_LEN; ++pos)
+    {
+        w.position_letters[pos].resize(size);
+        w.first_letters[pos].resize(size);
+        w.letter_runs[pos].resize(size);
+    }
 
-        // Precompile all patterns
-        auto &table = w.e->pattern_table;
-        for (int i = 0; i < wordCount; ++i)
+    std::array<uint32_t, 26> run = {0};
+    for (size_t word_idx = 0; word_idx < size; ++word_idx)
+    {
+        const char *word = w.chars(word_idx);
+        uint32_t seen = 0;
+        for (int pos = 0; pos < WORD_LEN; ++pos)
         {
-            const char *guess = w.strings[i].c_str();
+            int c = word[pos] - 'a';
+            w.position_letters[pos][word_idx] = c;
+            w.first_letters[pos][word_idx] = !(seen & (1u << c));
+            w.letter_runs[pos][word_idx] = ++run[c];
+            seen |= 1u << c;
+        }
+    }
+}
 
-            for (int j = 0; j < wordCount; ++j)
+/**
+ * Wordle feedback of guess against target, encoded in base 3.
+ *
+ * @param counts Letter counts of target, indexed by letter - 'a'
+ * @return 0 - Grey, 1 - Yellow, 2 - Green per letter, first letter most significant
+ */
+inline pattern_t computePattern(const char *guess, const char *target, const uint8_t *counts)
+{
+    alignas(32) uint8_t remaining[32];
+    std::memcpy(remaining, counts, 32);
+    uint8_t pattern[WORD_LEN];
+
+    for (int k = 0; k < WORD_LEN; ++k)
+    {
+        bool green = guess[k] == target[k];
+        pattern[k] = green ? 2 : 0;
+        remaining[(uint8_t)(target[k] - 'a')] -= green;
+    }
+
+    pattern_t encoding = 0;
+    for (int k = 0; k < WORD_LEN; ++k)
+    {
+        if (pattern[k] == 0)
+        {
+            uint8_t &left = remaining[(uint8_t)(guess[k] - 'a')];
+            if (left > 0)
             {
-                const char *target = w.strings[j].c_str();
+                pattern[k] = 1; // Yellow
+                left--;
+            }
+        }
 
-                std::array<uint8_t, 26> remaining{};
-                std::array<uint8_t, 5> pattern{};
+        // Encode pattern in base 3
+        encoding = encoding * 3 + pattern[k];
+    }
+    return encoding;
+}
 
-                // fill remaining with target letter counts BEFORE marking greens
-                for (int t = 0; t < 5; ++t)
-                    ++remaining[(uint8_t)(target[t] - 'a')];
+inline pattern_t computePattern(const char *guess, const char *target)
+{
+    alignas(32) uint8_t counts[32] = {0};
+    for (int t = 0; t < WORD_LEN; ++t)
+        ++counts[(uint8_t)(target[t] - 'a')];
+    return computePattern(guess, target, counts);
+}
 
-                for (int k = 0; k < 5; ++k)
-                {
-                    if (guess[k] == target[k])
-                    {
-                        pattern[k] = 2; // Green
-                        remaining[(uint8_t)(target[k] - 'a')]--;
-                    }
-                }
-                
-                for (int k = 0; k < 5; ++k)
+/**
+ * Allocate and fill w.e (klogk and the guess x target pattern table).
+ *
+ * @param w Loaded dictionary
+ * @param threads Worker count, <= 0 uses every hardware thread
+ * @param progress Optional, called with (rows done, total rows). Only ever called
+ *        from one thread at a time
+ * @return Build time in milliseconds
+ *
+ * @note Work is split into GUESS_TILE x TARGET_TILE blocks so the packed letters
+ *       of both sides stay in L1/L2 while a block is filled
+ */
+double buildPatternTable(words &w, int threads, const std::function<void(int, int)> &progress)
+{
+    constexpr int GUESS_TILE = 32;
+    constexpr int TARGET_TILE = 1024; // 5 KB of letters, 32 KB of counts
+
+    auto start = std::chrono::steady_clock::now();
+
+    const int wordCount = w.strings.size();
+    const int answerCount = w.answers.size();
+    delete w.e;
+    w.e = new entropy(w);
+
+    // Precompute klogk
+    auto &klogk = w.e->klogk_storage;
+    for (int i = 1; i <= answerCount; ++i)
+    {
+        // klokgk[0] = 0.0
+        klogk[i] = (double)i * std::log2((double)i);
+    }
+
+    // Guesses are already packed, pack letters and letter counts of every answer in column order
+    std::vector<char> targets((size_t)answerCount * WORD_LEN);
+    std::vector<std::array<uint8_t, 32>> counts(answerCount);
+    for (int word_idx : w.answers)
+    {
+        const char *answer = w.chars(word_idx);
+        const uint32_t j = w.e->column[word_idx];
+        std::memcpy(&targets[(size_t)j * WORD_LEN], answer, WORD_LEN);
+        counts[j].fill(0);
+        for (int k = 0; k < WORD_LEN; ++k)
+            ++counts[j][(uint8_t)(answer[k] - 'a')];
+    }
+
+    pattern_t *table = w.e->table_storage.data();
+    const int guessTiles = (wordCount + GUESS_TILE - 1) / GUESS_TILE;
+    std::atomic<int> rowsDone{0};
+    std::mutex progressLock;
+
+    parallelFor(
+        guessTiles,
+        threads,
+        [&](int, int tile)
+        {
+            const int g0 = tile * GUESS_TILE;
+            const int g1 = std::min(g0 + GUESS_TILE, wordCount);
+
+            for (int t0 = 0; t0 < answerCount; t0 += TARGET_TILE)
+            {
+                const int t1 = std::min(t0 + TARGET_TILE, answerCount);
+                for (int i = g0; i < g1; ++i)
                 {
-                    if (pattern[k] == 2)
-                        continue;
+                    const char *guess = w.chars(i);
+                    pattern_t *row = table + (size_t)i * answerCount;
 
-                    uint8_t char_idx = (uint8_t)(guess[k] - 'a');
-                    if (remaining[char_idx] > 0)
-                    {
-                        pattern[k] = 1; // Yellow
-                        remaining[char_idx]--;
-                    }
-                    else
-                        pattern[k] = 0; // Gray
+                    // i = guess index, j = table column
+                    for (int j = t0; j < t1; ++j)
+                        row[j] = computePattern(guess, &targets[(size_t)j * WORD_LEN], counts[j].data());
                 }
+            }
 
-                // Encode pattern in base 3
-                uint8_t encoding = 0;
-                for (int k = 0; k < 5; ++k)
-                    encoding = encoding * 3 + pattern[k];
-
-                // i = guess index, j = target index
-                table[i * wordCount + j] = encoding;
+            int done = rowsDone.fetch_add(g1 - g0) + (g1 - g0);
+            if (progress && progressLock.try_lock())
+            {
+                progress(done, wordCount);
+                progressLock.unlock();
             }
-        }
+        });
+
+    if (progress)
+        progress(wordCount, wordCount);
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Table column of every answer: answers sorted by their patterns against COLUMN_PROBES,
+ * ties kept in word order.
+ *
+ * @return Word index -> column, 0 for words that are not answers
+ */
+std::vector<uint32_t> columnOrder(const words &w)
+{
+    std::vector<std::pair<uint64_t, int>> keys;
+    keys.reserve(w.answers.size());
+    for (int word_idx : w.answers)
+    {
+        uint64_t key = 0;
+        for (const char *probe : COLUMN_PROBES)
+            key = key * PATTERN_COUNT + computePattern(probe, w.chars(word_idx));
+        keys.emplace_back(key, word_idx);
     }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<uint32_t> column(w.strings.size(), 0);
+    for (uint32_t j = 0; j < keys.size(); ++j)
+        column[keys[j].second] = j;
+    return column;
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                      Pattern Table Cache
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * FNV-1a over every word (and WORD_LEN), identifies which dictionary a cache belongs to.
+ */
+uint64_t dictionaryHash(const words &w)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](uint8_t byte)
+    {
+        hash ^= byte;
+        hash *= 0x100000001b3ull;
+    };
+
+    mix(WORD_LEN);
+    for (const auto &word : w.strings)
+    {
+        for (char c : word)
+            mix((uint8_t)c);
+        mix('\n');
+    }
+
+    // Answer list and column order change the table too
+    for (int word_idx : w.answers)
+        for (int b = 0; b < 4; ++b)
+            mix((uint8_t)(word_idx >> (8 * b)));
+    for (const char *probe : COLUMN_PROBES)
+        for (int i = 0; i < WORD_LEN; ++i)
+            mix((uint8_t)probe[i]);
+    return hash;
+}
+
+/**
+ * Map a previously saved pattern table read-only and point w.e into it.
+ *
+ * @param hugePages Hint the kernel to use huge pages for the mapping
+ * @return false if the file is missing or was written for another dictionary/version
+ */
+bool loadPatternCache(words &w, const std::string &path, bool hugePages)
+{
+    auto *e = new entropy();
+    if (!e->cache.open(path, hugePages) || e->cache.size < sizeof(PatternCacheHeader))
+    {
+        delete e;
+        return false;
+    }
+
+    const uint64_t wordCount = w.strings.size();
+    const uint64_t answerCount = w.answers.size();
+    PatternCacheHeader header;
+    std::memcpy(&header, e->cache.data, sizeof(header));
+
+    bool valid = std::memcmp(header.magic, "WRDLPTC", 8) == 0 &&
+                 header.version == CACHE_VERSION &&
+                 header.wordLen == WORD_LEN &&
+                 header.wordCount == wordCount &&
+                 header.answerCount == answerCount &&
+                 header.tableSize == wordCount * answerCount &&
+                 header.klogkOffset + (answerCount + 1) * sizeof(double) <= header.tableOffset &&
+                 header.tableOffset + header.tableSize * sizeof(pattern_t) <= e->cache.size &&
+                 header.dictHash == dictionaryHash(w);
+
+    if (!valid)
+    {
+        delete e;
+        return false;
+    }
+
+    e->klogk = (const double *)(e->cache.data + header.klogkOffset);
+    e->pattern_table = (const pattern_t *)(e->cache.data + header.tableOffset);
+    e->column = columnOrder(w);
+
+    delete w.e;
+    w.e = e;
+    return true;
+}
+
+/**
+ * Write w.e to disk in the PatternCacheHeader format.
+ *
+ * @note Written to a temporary file named after the process, then renamed over
+ *       path: solvers starting together never share a half-written file, and
+ *       readers see either the old table or the new one
+ */
+bool savePatternCache(const words &w, const std::string &path)
+{
+    if (w.e == nullptr)
+        return false;
+
+    const uint64_t wordCount = w.strings.size();
+    const uint64_t answerCount = w.answers.size();
+    PatternCacheHeader header = {};
+    std::memcpy(header.magic, "WRDLPTC", 8);
+    header.version = CACHE_VERSION;
+    header.wordLen = WORD_LEN;
+    header.wordCount = wordCount;
+    header.answerCount = answerCount;
+    header.dictHash = dictionaryHash(w);
+    header.klogkOffset = 64;
+    header.tableOffset = (header.klogkOffset + (answerCount + 1) * sizeof(double) + 4095) & ~4095ull;
+    header.tableSize = wordCount * answerCount;
+
+#ifdef _WIN32
+    const std::string tmpPath = path + "." + std::to_string(GetCurrentProcessId()) + ".tmp";
+#else
+    const std::string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+#endif
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        return false;
+
+    std::vector<char> padding(header.tableOffset, 0);
+    std::memcpy(padding.data(), &header, sizeof(header));
+    std::memcpy(padding.data() + header.klogkOffset, w.e->klogk, (answerCount + 1) * sizeof(double));
+    out.write(padding.data(), padding.size());
+    out.write((const char *)w.e->pattern_table, header.tableSize * sizeof(pattern_t));
+    out.close();
+
+    if (!out)
+    {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    // std::rename does not replace an existing file on Windows
+    bool renamed = MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+    if (!renamed)
+        std::remove(tmpPath.c_str());
+    return renamed;
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -227,6 +1057,7 @@ struct WordleGame
     WordleState *state;
     int currentTurn = 1;
     Status status = Status::NEXT_TURN;
+    pattern_t pattern = 0; // Last turn in base 3: 0 - Grey, 1 - Yellow, 2 - Green
 
     WordleGame(const std::string &word, WordleState *state)
     {
@@ -242,11 +1073,18 @@ struct WordleGame
         if (status != Status::NEXT_TURN)
             return status;
 
+        if (state->hardMode && !isLegalGuess(*state, guess.c_str()))
+            return Status::INVALID_TURN;
+
+        TRACE_TURN(currentTurn);
+        TRACE_SCOPE(TraceEvent::TURN, state->candidates);
+
         std::array<uint8_t, 26> tmp_maxSameChar = {0};
         std::array<uint8_t, 26> count_letters = {0};
         std::array<char, WORD_LEN> guess_recheck = {0};
-        std::vector<uint8_t> posIndex;
-        posIndex.reserve(WORD_LEN);
+        std::array<uint8_t, WORD_LEN> code = {0};
+        std::array<uint8_t, WORD_LEN> posIndex;
+        int misses = 0;
 
         // Check for matches
         for (size_t i = 0; i < WORD_LEN; ++i)
@@ -258,6 +1096,7 @@ struct WordleGame
             {
                 state->green[i] = gue_ch;
                 state->set_requireMask(i, gue_ch - 'a');
+                code[i] = 2;
 
                 tmp_maxSameChar[gue_ch - 'a']++;
             }
@@ -265,13 +1104,14 @@ struct WordleGame
             {
                 count_letters[wrd_ch - 'a']++;
                 guess_recheck[i] = gue_ch;
-                posIndex.push_back(i);
+                posIndex[misses++] = i;
             }
         }
 
         // Go through non-matching letters
-        for (const auto i : posIndex)
+        for (int k = 0; k < misses; ++k)
         {
+            const auto i = posIndex[k];
             uint8_t char_idx = guess_recheck[i] - 'a';
 
             if (count_letters[char_idx] > 0)
@@ -279,6 +1119,7 @@ struct WordleGame
                 state->set_yellow(i, char_idx);
                 state->set_requireMask(i, char_idx);
                 --count_letters[char_idx];
+                code[i] = 1;
 
                 tmp_maxSameChar[char_idx]++;
             }
@@ -293,8 +1134,16 @@ struct WordleGame
             if (tmp_maxSameChar[i] > state->maxSameChar[i])
                 state->maxSameChar[i] = tmp_maxSameChar[i];
 
+        pattern = 0;
+        for (size_t i = 0; i < WORD_LEN; ++i)
+            pattern = pattern * 3 + code[i];
+
+        state->lastGuess = encode(guess);
+        state->lastPattern = pattern;
+        state->hasPattern = true;
+
         // All characters green
-        if (posIndex.size() == 0)
+        if (misses == 0)
             status = Status::WIN;
         // Last turn, no victory
         else if (currentTurn == 6)
@@ -309,22 +1158,111 @@ struct WordleGame
     }
 };
 
+/**
+ * Apply the colours a player reports for a guess, when the answer is unknown.
+ * Updates the state exactly like WordleGame::turn would with the real answer.
+ *
+ * @param guess Lowercase word of WORD_LEN letters
+ * @param feedback One letter per position: G|g - Green, Y|y - Yellow, X|x - Grey
+ * @return false if guess or feedback is malformed, or the guess breaks hard mode.
+ *         State is untouched then
+ */
+bool applyFeedback(WordleState &state, const std::string &guess, const std::string &feedback)
+{
+    if (guess.length() != WORD_LEN || feedback.length() != WORD_LEN)
+        return false;
+
+    for (int i = 0; i < WORD_LEN; ++i)
+    {
+        char c = feedback[i] | 0x20; // Lowercase
+        if (guess[i] < 'a' || guess[i] > 'z' || (c != 'g' && c != 'y' && c != 'x'))
+            return false;
+    }
+
+    if (state.hardMode && !isLegalGuess(state, guess.c_str()))
+        return false;
+
+    std::array<uint8_t, 26> tmp_maxSameChar = {0};
+    pattern_t pattern = 0;
+    for (int i = 0; i < WORD_LEN; ++i)
+    {
+        uint8_t char_idx = guess[i] - 'a';
+        pattern *= 3;
+
+        switch (feedback[i] | 0x20)
+        {
+        case 'g':
+            state.green[i] = guess[i];
+            state.set_requireMask(i, char_idx);
+            tmp_maxSameChar[char_idx]++;
+            pattern += 2;
+            break;
+
+        case 'y':
+            state.set_yellow(i, char_idx);
+            state.set_requireMask(i, char_idx);
+            tmp_maxSameChar[char_idx]++;
+            pattern += 1;
+            break;
+
+        default:
+            state.set_grey(char_idx);
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < 26; ++i)
+        if (tmp_maxSameChar[i] > state.maxSameChar[i])
+            state.maxSameChar[i] = tmp_maxSameChar[i];
+
+    state.lastGuess = encode(guess);
+    state.lastPattern = pattern;
+    state.hasPattern = true;
+    return true;
+}
+
 /**
  * Find all words who fit within the wordle requirements of a given WordleState.
  *
  * @param w Active dictionary object
  * @param state Candidates array is directly updated
  *
- * @note Prunes existing candidates
+ * @note Prunes existing candidates, and the guess pool in hard mode
  */
 void getCandidates(const words &w, WordleState &state)
 {
+    TRACE_SCOPE(TraceEvent::FILTER, state.candidates);
+
+    if (PATTERN_FILTER && state.hasPattern)
+        getCandidatesPattern(w, state);
+    else if (BITSET_FILTER)
+        getCandidatesBitset(w, state);
+    else
+        getCandidatesScan(w, state);
+
+    if (state.hardMode)
+        pruneGuessPool(w, state);
+}
+
+/**
+ * getCandidates' per-word constraint filtering, without the faster paths.
+ *
+ * @param w Active dictionary object
+ * @param state Candidates array is directly updated
+ */
+void getCandidatesScan(const words &w, WordleState &state)
+{
+    state.candidate_bits.clear();
     auto &candidates = state.candidates;
     const auto &reqCharMask = state.requiredCharMask;
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
 
     // First time, get candidates
     if (candidates.empty())
     {
+        state.hasCounts = false;
+
         // Get all words with Green/Yellow chars
         if (reqCharMask != 0)
         {
@@ -332,8 +1270,7 @@ void getCandidates(const words &w, WordleState &state)
             {
                 if (reqCharMask & (1u << i))
                 {
-                    char ch = 'a' + i;
-                    const std::vector<int> &current = w.inv_index.find(ch)->second;
+                    const std::vector<int> &current = w.inv_index[i];
 
                     if (candidates.size() == 0)
                     {
@@ -342,15 +1279,14 @@ void getCandidates(const words &w, WordleState &state)
                     else
                     {
                         // Get only words in both lists
-                        std::vector<int> intersection;
-                        intersection.reserve(candidates.size());
-
-                        std::set_intersection(
+                        TRACE_COUNT(intersections, 1);
+                        int *intersection = arena.alloc<int>(candidates.size());
+                        int *end = std::set_intersection(
                             candidates.begin(), candidates.end(),
                             current.begin(), current.end(),
-                            std::back_inserter(intersection));
+                            intersection);
 
-                        candidates = std::move(intersection);
+                        candidates.assign(intersection, end);
                     }
                 }
             }
@@ -359,51 +1295,50 @@ void getCandidates(const words &w, WordleState &state)
         else
         {
             // uint8_t is used instead of bool because it's faster
-            std::vector<uint8_t> excluded_idx(w.strings.size(), 0);
+            uint8_t *excluded_idx = arena.alloc<uint8_t>(w.strings.size());
+            std::memset(excluded_idx, 0, w.strings.size());
             for (int i = 0; i < 26; ++i)
             {
                 if (state.grey & (1u << i))
                 {
-                    char ch = 'a' + i;
-                    const std::vector<int> &current = w.inv_index.find(ch)->second;
+                    const std::vector<int> &current = w.inv_index[i];
 
                     for (int idx : current)
                         excluded_idx[idx] = 1;
                 }
             }
 
-            for (int i = 0; i < w.strings.size(); i++)
-                if (!excluded_idx[i])
-                    candidates.push_back(i);
+            for (int word_idx : w.answers)
+                if (!excluded_idx[word_idx])
+                    candidates.push_back(word_idx);
 
             // Done!
+            updateCandidateCounts(w, state, nullptr, 0);
             return;
         }
     }
 
-    std::vector<int> answer;
-    answer.reserve(candidates.size());
+    // Survivors are compacted in place, the removed words only update the counts
+    size_t kept = 0, removedCount = 0;
+    int *removed = arena.alloc<int>(candidates.size());
     uint32_t overlappingChars = state.grey & reqCharMask;
     uint32_t charsNotPresent = state.grey & ~reqCharMask;
 
-    for (int word_idx : candidates)
+    auto matches = [&](int word_idx)
     {
         // Word must contain all required letters
         if ((w.masks[word_idx] & reqCharMask) != reqCharMask)
-            continue;
+            return false;
 
         // Word must NOT contain letters that do not appear in the word
         if ((w.masks[word_idx] & charsNotPresent) != 0)
-            continue;
+            return false;
 
-        bool ok = true;
-        const auto &word = w.strings[word_idx];
-        std::array<uint8_t, 26> wordcountChars = {};
+        const char *word = w.chars(word_idx);
 
         for (int pos = 0; pos < WORD_LEN; ++pos)
         {
             char c = word[pos];
-            wordcountChars[c - 'a']++;
 
             // Skip already solved (green) letters
             if (state.solvedLetters[pos])
@@ -411,41 +1346,39 @@ void getCandidates(const words &w, WordleState &state)
 
             // green check
             if (state.green[pos] != 0 && state.green[pos] != c)
-            {
-                ok = false;
-                break;
-            }
+                return false;
             // yellow check
             else if (state.yellow[pos] != 0)
             {
                 uint32_t c_bit = 1u << (c - 'a');
                 if (state.yellow[pos] & c_bit)
-                {
-                    ok = false;
-                    break;
-                }
+                    return false;
             }
         }
 
-        if (!ok)
-            continue;
-
         // Check character quanitity in word
-        for (size_t i = 0; i < 26; ++i)
+        if (w.masks[word_idx] & overlappingChars)
         {
-            if (overlappingChars & (1u << i))
+            const uint8_t *copies = w.copiesOf(word_idx);
+            for (int pos = 0; pos < WORD_LEN; ++pos)
             {
-                if (wordcountChars[i] > state.maxSameChar[i])
-                {
-                    ok = false;
-                    break;
-                }
+                int c = word[pos] - 'a';
+                if ((overlappingChars & (1u << c)) && copies[pos] > state.maxSameChar[c])
+                    return false;
             }
         }
+        return true;
+    };
 
-        if (ok)
-            answer.push_back(word_idx);
+    for (int word_idx : candidates)
+    {
+        if (matches(word_idx))
+            candidates[kept++] = word_idx;
+        else
+            removed[removedCount++] = word_idx;
     }
+    candidates.resize(kept);
+    updateCandidateCounts(w, state, removed, removedCount);
 
     // Update solved letters
     for (int i = 0; i < WORD_LEN; ++i)
@@ -453,6 +1386,320 @@ void getCandidates(const words &w, WordleState &state)
         if (state.green[i] != 0)
             state.solvedLetters[i] = true;
     }
+}
+
+/**
+ * Bring the candidate letter counts in step after a filter pass: uncount the
+ * removed words, or recount the survivors when that list is shorter.
+ *
+ * @param state Filtered candidates, counts still describing the previous ones
+ * @param removed Words the filter dropped from the previous candidates
+ *
+ * @note Counts are rebuilt from the survivors whenever hasCounts is false
+ */
+void updateCandidateCounts(const words &w, WordleState &state, const int *removed, size_t removedCount)
+{
+    auto &positionCharCount = state.positionCharCount;
+    int sign = -1;
+    const int *list = removed;
+    size_t count = removedCount;
 
-    candidates = std::move(answer);
-}
\ No newline at end of file
+    if (!state.hasCounts || state.candidates.size() < removedCount)
+    {
+        positionCharCount = {};
+        sign = 1;
+        list = state.candidates.data();
+        count = state.candidates.size();
+    }
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        const char *word = w.chars(list[k]);
+        for (int pos = 0; pos < WORD_LEN; ++pos)
+            positionCharCount[pos][word[pos] - 'a'] += sign;
+    }
+    state.hasCounts = true;
+}
+
+/**
+ * Same result as getCandidates, computed with whole-dictionary bitset operations
+ * instead of a per-word loop.
+ *
+ * @param w Active dictionary object
+ * @param state Candidates array and candidate_bits are directly updated
+ */
+void getCandidatesBitset(const words &w, WordleState &state)
+{
+    auto &bits = state.candidate_bits;
+
+    // Start from the previous candidates, or every answer on the first call
+    if (state.candidates.empty())
+    {
+        bits = w.answer_bits;
+        state.hasCounts = false;
+    }
+    else if (bits.empty())
+    {
+        bits.reset(w.strings.size());
+        for (int idx : state.candidates)
+            bits.set(idx);
+    }
+
+    const uint32_t reqCharMask = state.requiredCharMask;
+    const uint32_t overlappingChars = state.grey & reqCharMask;
+    const uint32_t charsNotPresent = state.grey & ~reqCharMask;
+
+    for (int c = 0; c < 26; ++c)
+    {
+        uint32_t bit = 1u << c;
+
+        // Word must contain all required letters
+        if (reqCharMask & bit)
+            bits.and_with(w.letter_bits[c]);
+
+        // Word must NOT contain letters that do not appear in the word
+        if (charsNotPresent & bit)
+            bits.andnot_with(w.letter_bits[c]);
+
+        // Check character quantity in word
+        if ((overlappingChars & bit) && state.maxSameChar[c] < WORD_LEN)
+            bits.andnot_with(w.count_bits[c][state.maxSameChar[c] + 1]);
+    }
+
+    for (int pos = 0; pos < WORD_LEN; ++pos)
+    {
+        // Skip already solved (green) letters
+        if (state.solvedLetters[pos])
+            continue;
+
+        if (state.green[pos] != 0)
+            bits.and_with(w.position_bits[pos][state.green[pos] - 'a']);
+
+        uint32_t yellow = state.yellow[pos];
+        while (yellow)
+        {
+            bits.andnot_with(w.position_bits[pos][__builtin_ctz(yellow)]);
+            yellow &= yellow - 1;
+        }
+    }
+
+    // Update solved letters
+    for (int i = 0; i < WORD_LEN; ++i)
+    {
+        if (state.green[i] != 0)
+            state.solvedLetters[i] = true;
+    }
+
+    // Previous candidates the masks dropped
+    auto &candidates = state.candidates;
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
+    int *removed = arena.alloc<int>(candidates.size());
+    size_t removedCount = 0;
+    for (int idx : candidates)
+    {
+        removed[removedCount] = idx;
+        removedCount += !bits.test(idx);
+    }
+
+    candidates.clear();
+    bits.forEach(
+        [&candidates](int idx)
+        {
+            candidates.push_back(idx);
+        });
+    updateCandidateCounts(w, state, removed, removedCount);
+}
+
+/**
+ * Keep the candidates that would have produced the last observed pattern.
+ * One byte compare per candidate with a pattern table, computePattern otherwise.
+ *
+ * @param w Active dictionary object
+ * @param state Candidates array is directly updated
+ *
+ * @note Exact wordle rules, so it can prune more than getCandidates.
+ *       Falls back to getCandidates' constraint filtering for unknown guesses
+ */
+void getCandidatesPattern(const words &w, WordleState &state)
+{
+    auto it = w.word_index.find(state.lastGuess);
+    if (it == w.word_index.end())
+    {
+        if (BITSET_FILTER)
+            return getCandidatesBitset(w, state);
+        return getCandidatesScan(w, state);
+    }
+
+    const int guess_idx = it->second;
+    const pattern_t code = state.lastPattern;
+    auto &candidates = state.candidates;
+
+    // First time, every answer is a candidate
+    if (candidates.empty())
+    {
+        candidates = w.answers;
+        state.hasCounts = false;
+    }
+
+    // Branch-free in place compaction, the removed words go to their own list
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
+    int *removed = arena.alloc<int>(candidates.size());
+    size_t kept = 0, removedCount = 0;
+    if (w.e != nullptr)
+    {
+        const pattern_t *row = w.e->pattern_table + (size_t)guess_idx * w.answers.size();
+        const uint32_t *column = w.e->column.data();
+        TRACE_COUNT(tableBytes, candidates.size() * sizeof(pattern_t));
+        for (int word_idx : candidates)
+        {
+            bool match = row[column[word_idx]] == code;
+            candidates[kept] = word_idx;
+            removed[removedCount] = word_idx;
+            kept += match;
+            removedCount += !match;
+        }
+    }
+    else
+    {
+        const char *guess = w.chars(guess_idx);
+        for (int word_idx : candidates)
+        {
+            bool match = computePattern(guess, w.chars(word_idx)) == code;
+            candidates[kept] = word_idx;
+            removed[removedCount] = word_idx;
+            kept += match;
+            removedCount += !match;
+        }
+    }
+    candidates.resize(kept);
+    updateCandidateCounts(w, state, removed, removedCount);
+
+    // Update solved letters
+    for (int i = 0; i < WORD_LEN; ++i)
+    {
+        if (state.green[i] != 0)
+            state.solvedLetters[i] = true;
+    }
+
+    // Keep the bitset view in sync for algorithms that use it
+    state.candidate_bits.clear();
+    if (BITSET_FILTER)
+    {
+        state.candidate_bits.reset(w.strings.size());
+        for (int idx : candidates)
+            state.candidate_bits.set(idx);
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                          Hard Mode
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Hard mode rule: greens stay in place and every revealed letter is played at
+ * least as often as it was revealed. Yellows may go back to the same spot.
+ *
+ * @param guess WORD_LEN lowercase letters
+ */
+inline bool isLegalGuess(const WordleState &state, const char *guess)
+{
+    std::array<uint8_t, 26> count = {0};
+    uint32_t mask = 0;
+    bool legal = true;
+    for (int pos = 0; pos < WORD_LEN; ++pos)
+    {
+        legal &= state.green[pos] == 0 || guess[pos] == state.green[pos];
+        count[guess[pos] - 'a']++;
+        mask |= 1u << (guess[pos] - 'a');
+    }
+
+    // Revealed letters are exactly the required ones, each needs its copies
+    for (int pos = 0; pos < WORD_LEN; ++pos)
+        legal &= count[guess[pos] - 'a'] >= state.maxSameChar[guess[pos] - 'a'];
+    return legal && (mask & state.requiredCharMask) == state.requiredCharMask;
+}
+
+/**
+ * Drop the words that stopped being legal guesses from the guess pool, and from
+ * the candidates: a word breaking the rule cannot be the answer either.
+ *
+ * Same bitsets as getCandidatesBitset: the greens select a letter at a position,
+ * every revealed letter at least maxSameChar copies.
+ *
+ * @param state Starts from every word on the first call of a game
+ *
+ * @note Constraints only ever tighten, so each call ANDs them into the previous pool
+ */
+void pruneGuessPool(const words &w, WordleState &state)
+{
+    auto &bits = state.guess_bits;
+    if (bits.empty())
+        bits.set_all(w.strings.size());
+
+    for (int pos = 0; pos < WORD_LEN; ++pos)
+        if (state.green[pos] != 0)
+            bits.and_with(w.position_bits[pos][state.green[pos] - 'a']);
+
+    for (int c = 0; c < 26; ++c)
+        if (state.maxSameChar[c] != 0)
+            bits.and_with(w.count_bits[c][state.maxSameChar[c]]);
+
+    // Sized for the whole dictionary once, so refilling never allocates
+    auto &pool = state.guessPool;
+    pool.reserve(w.strings.size());
+    pool.clear();
+    bits.forEach(
+        [&pool](int idx)
+        {
+            pool.push_back(idx);
+        });
+
+    // The constraint filters only bound letter counts from above, so a candidate
+    // can still miss a second copy of a letter revealed twice
+    auto &candidates = state.candidates;
+    ScratchArena &arena = scratch();
+    ArenaScope scope(arena);
+    int *removed = arena.alloc<int>(candidates.size());
+    size_t kept = 0, removedCount = 0;
+    for (int word_idx : candidates)
+    {
+        bool legal = bits.test(word_idx);
+        candidates[kept] = word_idx;
+        removed[removedCount] = word_idx;
+        kept += legal;
+        removedCount += !legal;
+    }
+
+    if (removedCount == 0)
+        return;
+
+    candidates.resize(kept);
+    if (!state.candidate_bits.empty())
+        for (size_t k = 0; k < removedCount; ++k)
+            state.candidate_bits.unset(removed[k]);
+    updateCandidateCounts(w, state, removed, removedCount);
+}
+
+/**
+ * Call f(word_idx) for every word the player may guess next, in index order: the
+ * legal pool in hard mode, the whole dictionary otherwise.
+ *
+ * @param f Returns false to stop early
+ */
+template <typename F>
+inline void forEachGuess(const words &w, const WordleState &state, F f)
+{
+    if (state.hardMode && !state.guessPool.empty())
+    {
+        for (int word_idx : state.guessPool)
+            if (!f(word_idx))
+                return;
+        return;
+    }
+
+    for (int word_idx = 0; word_idx < (int)w.strings.size(); ++word_idx)
+        if (!f(word_idx))
+            return;
+}
@@ -0,0 +1,94 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+struct WorkQueue;
+int defaultThreadCount();
+template <typename Fn>
+void parallelFor(int count, int threads, Fn fn);
+
+/**
+ * A fixed range of job indices owned by one worker.
+ *
+ * The owner and any thieves both claim jobs with fetch_add on `next`,
+ * so a job is handed out exactly once no matter who takes it.
+ */
+struct alignas(64) WorkQueue
+{
+    std::atomic<int> next{0};
+    int end = 0;
+
+    inline int pop()
+    {
+        if (next.load(std::memory_order_relaxed) >= end)
+            return -1;
+
+        int idx = next.fetch_add(1, std::memory_order_relaxed);
+        return idx < end ? idx : -1;
+    }
+};
+
+int defaultThreadCount()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : (int)n;
+}
+
+/**
+ * Run fn(thread_id, job_idx) for every job in [0, count) across a number of threads.
+ *
+ * @param count Number of jobs
+ * @param threads Worker count, <= 0 uses every hardware thread
+ * @param fn Callable taking (int thread_id, int job_idx)
+ *
+ * @note Jobs are split into one contiguous range per thread. A thread that runs out
+ *       steals single jobs from the others, so uneven job lengths still balance out.
+ */
+template <typename Fn>
+void parallelFor(int count, int threads, Fn fn)
+{
+    if (threads <= 0)
+        threads = defaultThreadCount();
+    threads = std::max(1, std::min(threads, count));
+
+    if (threads == 1)
+    {
+        for (int i = 0; i < count; ++i)
+            fn(0, i);
+        return;
+    }
+
+    std::vector<WorkQueue> queues(threads);
+    for (int t = 0; t < threads; ++t)
+    {
+        queues[t].next = (int)((long long)count * t / threads);
+        queues[t].end = (int)((long long)count * (t + 1) / threads);
+    }
+
+    auto worker = [&](int tid)
+    {
+        // Own queue first
+        int idx;
+        while ((idx = queues[tid].pop()) != -1)
+            fn(tid, idx);
+
+        // Steal from everyone else, starting with the neighbour
+        for (int k = 1; k < threads; ++k)
+        {
+            auto &victim = queues[(tid + k) % threads];
+            while ((idx = victim.pop()) != -1)
+                fn(tid, idx);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back(worker, t);
+
+    worker(0);
+
+    for (auto &th : pool)
+        th.join();
+}
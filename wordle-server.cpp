@@ -0,0 +1,666 @@
+#include "wordle-tree.cpp"
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#define SESSION_SHARDS 64
+#define SESSION_LIMIT (1 << 16) // Live sessions, idle ones are dropped to make room
+#define SESSION_TTL 3600        // Seconds a session may stay idle before it can be dropped
+#define CONNECTION_LIMIT 64     // Socket clients served at once, more wait in the listen backlog
+#define LINE_LIMIT 4096         // Bytes per request line, longer lines are answered with an error
+
+struct ServerOptions;
+struct Session;
+struct SessionTable;
+struct Server;
+bool parseJsonLine(const std::string &line, std::unordered_map<std::string, std::string> &fields);
+void serveStream(Server &server, std::istream &in, std::ostream &out);
+#ifndef _WIN32
+void serveSocket(Server &server, const std::string &path, size_t maxConnections);
+#endif
+
+/*
+    Line protocol, one JSON object per line in both directions:
+
+    {"session": "s1", "guess": "salet", "feedback": "xyxxg"}  Play a turn, the first valid one starts the session
+    {"session": "s1", "op": "suggest"}                       Suggestion for the current state
+    {"session": "s1", "op": "end"}                           Forget the session
+    {"op": "stats"}                                          Server counters
+
+    An optional "id" is echoed back. Every reply carries "ok" and "latency_us",
+    turn replies add "turn", "candidates", "suggestion" and "solved", failures "error".
+    Lines longer than LINE_LIMIT bytes are skipped and answered with an error.
+*/
+
+struct ServerOptions
+{
+    std::string algorithm = "entropy_fast";
+    std::string firstGuess = DEFAULT_WORDS.opener;
+    std::string socketPath; // "" - stdin/stdout
+    std::string dictionary = WORD_URL;
+    std::string answers = ANSWER_URL; // "" - Every word is a possible answer
+    size_t cacheSize = 1 << 20;
+    size_t maxSessions = SESSION_LIMIT;
+    size_t maxConnections = CONNECTION_LIMIT;
+    int sessionTtl = SESSION_TTL; // Seconds
+    bool hugePages = false; // Map the cached pattern table with huge pages
+};
+
+struct Session
+{
+    std::mutex lock; // Requests of one session are served in order
+    WordleState state;
+    int turn = 1;
+    bool finished = false;
+    std::atomic<int64_t> lastUsed{0}; // steady_clock seconds, read by eviction without the lock
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    inline void touch()
+    {
+        lastUsed.store(now(), std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Session id -> Session, sharded so concurrent connections rarely share a lock.
+ *
+ * Each shard holds at most maxSessions / SESSION_SHARDS sessions. A full shard
+ * drops the ones idle for longer than ttl before refusing new sessions.
+ *
+ * @note Shared ownership, so ending or dropping a session while another request
+ *       on it is still running cannot free it under that request
+ */
+struct SessionTable
+{
+    struct alignas(64) Shard
+    {
+        std::mutex lock;
+        std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
+    };
+    std::array<Shard, SESSION_SHARDS> shards;
+    size_t shardCapacity = SESSION_LIMIT / SESSION_SHARDS;
+    int64_t ttl = SESSION_TTL; // Seconds
+
+    inline Shard &shard(const std::string &id)
+    {
+        return shards[std::hash<std::string>()(id) % SESSION_SHARDS];
+    }
+
+    // Existing session or nullptr, never inserts
+    std::shared_ptr<Session> find(const std::string &id)
+    {
+        Shard &s = shard(id);
+        std::lock_guard<std::mutex> guard(s.lock);
+        auto it = s.sessions.find(id);
+        if (it == s.sessions.end())
+            return nullptr;
+
+        it->second->touch();
+        return it->second;
+    }
+
+    /**
+     * Store a new session under id.
+     *
+     * @return session, the session another request stored under id first,
+     *         or nullptr if the shard is full of sessions used within ttl
+     */
+    std::shared_ptr<Session> insert(const std::string &id, const std::shared_ptr<Session> &session)
+    {
+        Shard &s = shard(id);
+        std::lock_guard<std::mutex> guard(s.lock);
+        auto it = s.sessions.find(id);
+        if (it != s.sessions.end())
+            return it->second;
+
+        if (s.sessions.size() >= shardCapacity)
+        {
+            const int64_t expired = Session::now() - ttl;
+            std::erase_if(
+                s.sessions,
+                [expired](const auto &entry)
+                {
+                    return entry.second->lastUsed.load(std::memory_order_relaxed) < expired;
+                });
+            if (s.sessions.size() >= shardCapacity)
+                return nullptr;
+        }
+
+        session->touch();
+        s.sessions.emplace(id, session);
+        return session;
+    }
+
+    bool erase(const std::string &id)
+    {
+        Shard &s = shard(id);
+        std::lock_guard<std::mutex> guard(s.lock);
+        return s.sessions.erase(id) != 0;
+    }
+
+    size_t size()
+    {
+        size_t total = 0;
+        for (auto &s : shards)
+        {
+            std::lock_guard<std::mutex> guard(s.lock);
+            total += s.sessions.size();
+        }
+        return total;
+    }
+};
+
+/**
+ * Dictionary, pattern table and transposition cache loaded once and shared by
+ * every session and connection.
+ */
+struct Server
+{
+    using Algorithm = const std::string &(*)(const words &, const WordleState &);
+
+    words w;
+    TranspositionCache cache;
+    CachedAlgorithm<Algorithm> algorithm;
+    std::string firstGuess;
+    SessionTable sessions;
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> errors{0};
+
+    Server(const ServerOptions &options) : cache(options.cacheSize), firstGuess(options.firstGuess)
+    {
+        sessions.shardCapacity = std::max<size_t>(1, options.maxSessions / SESSION_SHARDS);
+        sessions.ttl = options.sessionTtl;
+
+        const std::vector<std::pair<std::string, Algorithm>> algorithms = {
+            {"idxmiddle", algo_idxmiddle},
+            {"normal", algo_normal},
+            {"test1", algo_test1},
+            {"entropy_fast", algo_entropy_fast},
+            {"entropy_full", algo_entropy_full},
+            {"minimax", algo_minimax},
+            {"expected", algo_expected},
+            {"mostparts", algo_mostparts}};
+
+        auto it = std::find_if(algorithms.begin(), algorithms.end(),
+                               [&](const auto &entry)
+                               {
+                                   return entry.first == options.algorithm;
+                               });
+        if (it == algorithms.end())
+        {
+            std::cerr << "Unknown algorithm: " << options.algorithm << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        algorithm = {it->second, &cache};
+
+        // stdout carries the protocol, keep load messages off it
+        auto *saved = std::cout.rdbuf(std::cerr.rdbuf());
+        loadWords(w, CALCULATE_ENTROPY, options.dictionary, options.answers, options.hugePages);
+        std::cout.rdbuf(saved);
+
+        if (firstGuess.length() != WORD_LEN || !w.word_index.count(encode(firstGuess)))
+        {
+            std::cerr << firstGuess << " is an invalid word!\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /**
+     * Reply to a request that could not be read, such as an over-long line.
+     */
+    std::string reject(const std::string &error)
+    {
+        requests.fetch_add(1, std::memory_order_relaxed);
+        errors.fetch_add(1, std::memory_order_relaxed);
+        return "{\"ok\": false, \"error\": \"" + jsonEscape(error) + "\", \"latency_us\": 0.0}";
+    }
+
+    /**
+     * Serve one request line.
+     *
+     * @return The reply line, without the trailing newline
+     */
+    std::string handle(const std::string &line)
+    {
+        auto start = std::chrono::steady_clock::now();
+        requests.fetch_add(1, std::memory_order_relaxed);
+
+        std::unordered_map<std::string, std::string> request;
+        std::ostringstream reply;
+        reply << "{";
+
+        auto finish = [&](const std::string &error)
+        {
+            if (!error.empty())
+            {
+                errors.fetch_add(1, std::memory_order_relaxed);
+                reply << "\"ok\": false, \"error\": \"" << jsonEscape(error) << "\", ";
+            }
+            else
+                reply << "\"ok\": true, ";
+
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            reply << "\"latency_us\": " << std::fixed << std::setprecision(1) << us << "}";
+            return reply.str();
+        };
+
+        if (!parseJsonLine(line, request))
+            return finish("malformed request");
+
+        if (request.count("id"))
+            reply << "\"id\": \"" << jsonEscape(request["id"]) << "\", ";
+
+        const std::string op = request.count("op") ? request["op"] : "guess";
+        if (op == "stats")
+        {
+            reply << "\"sessions\": " << sessions.size()
+                  << ", \"requests\": " << requests.load()
+                  << ", \"errors\": " << errors.load()
+                  << ", \"cache_hits\": " << cache.hits()
+                  << ", \"cache_misses\": " << cache.misses() << ", ";
+            return finish("");
+        }
+
+        if (!request.count("session") || request["session"].empty())
+            return finish("missing session");
+
+        const std::string &id = request["session"];
+        reply << "\"session\": \"" << jsonEscape(id) << "\", ";
+
+        if (op == "end")
+            return finish(sessions.erase(id) ? "" : "unknown session");
+
+        if (op != "guess" && op != "suggest")
+            return finish("unknown op");
+
+        // A session only exists once a guess on it was accepted, so typos and
+        // unknown ids leave nothing behind
+        std::shared_ptr<Session> session = sessions.find(id);
+        if (!session && op == "suggest")
+            return finish("unknown session");
+
+        const bool starting = !session;
+        if (starting)
+            session = std::make_shared<Session>();
+        std::lock_guard<std::mutex> guard(session->lock);
+
+        if (op == "guess")
+        {
+            std::string guess = request["guess"];
+            std::transform(guess.begin(), guess.end(), guess.begin(), ::tolower);
+
+            if (session->finished)
+                return finish("session finished");
+            if (guess.length() != WORD_LEN || !w.word_index.count(encode(guess)))
+                return finish("unknown word");
+
+            // Inconsistent feedback must not leave the session without candidates
+            WordleState next = session->state;
+            if (!applyFeedback(next, guess, request["feedback"]))
+                return finish("malformed feedback");
+
+            getCandidates(w, next);
+            if (next.candidates.empty())
+                return finish("no word matches the feedback");
+
+            if (starting)
+            {
+                std::shared_ptr<Session> stored = sessions.insert(id, session);
+                if (!stored)
+                    return finish("too many sessions");
+                if (stored != session)
+                    return finish("session started by another request");
+            }
+
+            session->state = std::move(next);
+            session->finished = session->state.lastPattern == ALL_GREEN || session->turn == MAX_TURNS;
+            session->turn++;
+        }
+
+        const WordleState &state = session->state;
+        const bool solved = state.hasPattern && state.lastPattern == ALL_GREEN;
+        const size_t candidates = state.hasPattern ? state.candidates.size() : w.answers.size();
+
+        reply << "\"turn\": " << session->turn
+              << ", \"candidates\": " << candidates
+              << ", \"solved\": " << (solved ? "true" : "false");
+        if (!session->finished)
+        {
+            TRACE_SCOPE(TraceEvent::ALGORITHM, state.candidates);
+            const std::string &suggestion = state.hasPattern ? algorithm(w, state) : firstGuess;
+            reply << ", \"suggestion\": \"" << suggestion << "\"";
+        }
+        reply << ", ";
+        return finish("");
+    }
+};
+
+// -------------------------------------------------------------------------------------------------
+//                                        JSON Lines
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Parse a flat JSON object of string, number and boolean values.
+ * Numbers and booleans are kept as their text.
+ *
+ * @return false on anything else (nesting, arrays, trailing garbage)
+ */
+bool parseJsonLine(const std::string &line, std::unordered_map<std::string, std::string> &fields)
+{
+    size_t i = 0;
+    auto skipSpace = [&]()
+    {
+        while (i < line.size() && std::isspace((unsigned char)line[i]))
+            ++i;
+    };
+    auto parseString = [&](std::string &out)
+    {
+        if (i >= line.size() || line[i] != '"')
+            return false;
+        for (++i; i < line.size(); ++i)
+        {
+            char c = line[i];
+            if (c == '"')
+            {
+                ++i;
+                return true;
+            }
+            if (c == '\\')
+            {
+                if (++i >= line.size())
+                    return false;
+                switch (line[i])
+                {
+                case 'n':
+                    out += '\n';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 'u':
+                    return false; // Never needed by the protocol
+                default:
+                    out += line[i];
+                    break;
+                }
+            }
+            else
+                out += c;
+        }
+        return false;
+    };
+
+    skipSpace();
+    if (i >= line.size() || line[i++] != '{')
+        return false;
+
+    skipSpace();
+    if (i < line.size() && line[i] == '}')
+    {
+        ++i;
+        skipSpace();
+        return i == line.size();
+    }
+
+    while (true)
+    {
+        std::string key, value;
+        skipSpace();
+        if (!parseString(key))
+            return false;
+
+        skipSpace();
+        if (i >= line.size() || line[i++] != ':')
+            return false;
+
+        skipSpace();
+        if (i < line.size() && line[i] == '"')
+        {
+            if (!parseString(value))
+                return false;
+        }
+        else
+        {
+            while (i < line.size() && (std::isalnum((unsigned char)line[i]) || line[i] == '-' || line[i] == '.' || line[i] == '+'))
+                value += line[i++];
+            if (value.empty())
+                return false;
+        }
+        fields[key] = value;
+
+        skipSpace();
+        if (i < line.size() && line[i] == ',')
+        {
+            ++i;
+            continue;
+        }
+        if (i < line.size() && line[i] == '}')
+        {
+            ++i;
+            skipSpace();
+            return i == line.size();
+        }
+        return false;
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                         Transports
+// -------------------------------------------------------------------------------------------------
+
+void serveStream(Server &server, std::istream &in, std::ostream &out)
+{
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+            continue;
+
+        out << (line.size() > LINE_LIMIT ? server.reject("request too long") : server.handle(line)) << "\n";
+        out.flush();
+    }
+}
+
+#ifndef _WIN32
+/**
+ * Accept connections on a Unix domain socket, one thread per connection, at most
+ * maxConnections at once. Sessions are global, a client may continue a session
+ * on another connection.
+ */
+void serveSocket(Server &server, const std::string &path, size_t maxConnections)
+{
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Error: Could not create socket " << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 64) != 0)
+    {
+        std::cerr << "Error: Could not listen on " << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // A client hanging up mid-reply must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+    std::cerr << "Listening on " << path << std::endl;
+
+    // Connection threads still running, new clients are only accepted below the limit
+    std::mutex lock;
+    std::condition_variable released;
+    size_t active = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            released.wait(guard, [&]
+                          { return active < maxConnections; });
+        }
+
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+            continue;
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ++active;
+        }
+
+        std::thread(
+            [&server, &lock, &released, &active, client]()
+            {
+                std::string pending, replies;
+                bool skipping = false; // Dropping the rest of an over-long line
+                char buffer[4096];
+                ssize_t received;
+                while ((received = read(client, buffer, sizeof(buffer))) > 0)
+                {
+                    pending.append(buffer, received);
+
+                    // Answer every complete line, pipelined requests get one write
+                    size_t start = 0, end;
+                    while ((end = pending.find('\n', start)) != std::string::npos)
+                    {
+                        std::string line = pending.substr(start, end - start);
+                        start = end + 1;
+                        if (skipping)
+                        {
+                            skipping = false;
+                            continue;
+                        }
+                        if (!line.empty() && line.back() == '\r')
+                            line.pop_back();
+                        if (line.size() > LINE_LIMIT)
+                            replies += server.reject("request too long") + "\n";
+                        else if (!line.empty())
+                            replies += server.handle(line) + "\n";
+                    }
+                    pending.erase(0, start);
+
+                    // No newline within the limit: answer now and drop the line as it arrives
+                    if (pending.size() > LINE_LIMIT + 1)
+                    {
+                        if (!skipping)
+                            replies += server.reject("request too long") + "\n";
+                        skipping = true;
+                        pending.clear();
+                    }
+
+                    size_t sent = 0;
+                    while (sent < replies.size())
+                    {
+                        ssize_t n = write(client, replies.data() + sent, replies.size() - sent);
+                        if (n <= 0)
+                            break;
+                        sent += n;
+                    }
+                    replies.clear();
+                }
+                close(client);
+
+                std::lock_guard<std::mutex> guard(lock);
+                --active;
+                released.notify_one();
+            })
+            .detach();
+    }
+}
+#endif
+
+int main(int argc, char const *argv[])
+{
+    ServerOptions options;
+    const char *usage = "Usage: wordle-server [--algo entropy_fast] [--first WORD] [--socket PATH] [--cache SLOTS] [--words PATH] [--answers PATH] [--max-sessions N] [--max-connections N] [--session-ttl SECONDS] [--huge-pages]\n";
+
+    // Whole decimal number >= min, anything else throws
+    auto number = [](const char *text, long long min)
+    {
+        size_t end = 0;
+        long long value = std::stoll(text, &end);
+        if (text[end] != '\0' || value < min)
+            throw std::invalid_argument(text);
+        return value;
+    };
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg != "--huge-pages" && ++i == argc)
+                arg.clear();
+
+            if (arg == "--huge-pages")
+                options.hugePages = true;
+            else if (arg == "--algo")
+                options.algorithm = argv[i];
+            else if (arg == "--first")
+                options.firstGuess = argv[i];
+            else if (arg == "--socket")
+                options.socketPath = argv[i];
+            else if (arg == "--cache")
+                options.cacheSize = number(argv[i], 0);
+            else if (arg == "--words")
+                options.dictionary = argv[i];
+            else if (arg == "--answers")
+                options.answers = argv[i];
+            else if (arg == "--max-sessions")
+                options.maxSessions = number(argv[i], 1);
+            else if (arg == "--max-connections")
+                options.maxConnections = number(argv[i], 1);
+            else if (arg == "--session-ttl")
+                options.sessionTtl = (int)std::min<long long>(number(argv[i], 1), std::numeric_limits<int>::max());
+            else
+            {
+                std::cerr << usage;
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception &)
+    {
+        // std::invalid_argument or std::out_of_range from a numeric flag
+        std::cerr << usage;
+        return 1;
+    }
+
+    Server server(options);
+
+    if (options.socketPath.empty())
+    {
+        std::ios::sync_with_stdio(false);
+        serveStream(server, std::cin, std::cout);
+
+        // stdout carries the protocol, the summary goes to stderr
+        if (TRACE_HOT_PATH)
+            flushTrace(TRACE_URL, std::cerr);
+        return 0;
+    }
+
+#ifdef _WIN32
+    std::cerr << "Unix sockets are not supported on Windows, serve over stdin/stdout instead\n";
+    return 1;
+#else
+    serveSocket(server, options.socketPath, options.maxConnections);
+#endif
+    return 0;
+}
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef TRACE_HOT_PATH
+#define TRACE_HOT_PATH false // Time and count the solve loop per thread, build with -DTRACE_HOT_PATH=true
+#endif
+
+#define TRACE_URL "solve-trace.csv" // .csv is written as text, any other extension as binary
+#define TRACE_VERSION 1
+#ifndef TRACE_CAPACITY
+#define TRACE_CAPACITY (1 << 16) // Records per thread (power of 2), a full buffer overwrites its oldest
+#endif
+
+enum class TraceEvent : uint8_t;
+struct TraceRecord;
+struct TraceTotals;
+struct TraceHeader;
+struct TraceBuffer;
+struct TraceScope;
+uint64_t traceCycles();
+bool flushTrace(const std::string &path, std::ostream &report = std::cout);
+
+enum class TraceEvent : uint8_t
+{
+    TURN,      // WordleGame::turn
+    FILTER,    // getCandidates, candidates after filtering
+    ALGORITHM, // Algorithm call, candidates it was given
+};
+
+/**
+ * One timed scope. Counters are what the scope added on its thread.
+ */
+struct TraceRecord
+{
+    uint64_t start;         // traceCycles() on entry
+    uint32_t cycles;        // Duration, saturated
+    uint32_t candidates;    // Candidate count when the scope ended
+    uint32_t intersections; // Sorted list intersections and bitset AND/ANDNOT passes
+    uint32_t tableBytes;    // Pattern table bytes read, saturated
+    uint32_t game;          // Per thread game number, counts turn 1s
+    uint16_t lane;          // Buffer the record came from, one per live thread
+    TraceEvent event;
+    uint8_t turn;
+};
+
+// Sums over every record of one event, overwritten ones included
+struct TraceTotals
+{
+    uint64_t count = 0, cycles = 0, candidates = 0, intersections = 0, tableBytes = 0;
+
+    inline void add(const TraceRecord &r)
+    {
+        count++;
+        cycles += r.cycles;
+        candidates += r.candidates;
+        intersections += r.intersections;
+        tableBytes += r.tableBytes;
+    }
+};
+
+/**
+ * Binary trace layout, followed by recordCount TraceRecords.
+ */
+struct TraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    double cyclesPerSecond;
+    uint64_t recordCount;
+    uint64_t dropped; // Overwritten before the flush
+};
+
+/**
+ * Cycle counter: the TSC on x86, steady_clock nanoseconds elsewhere.
+ */
+inline uint64_t traceCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+#if TRACE_HOT_PATH
+/**
+ * Ring of records and running counters of one thread.
+ *
+ * @note Only its thread writes to it, so recording takes no lock. A thread
+ *       hands its buffer back on exit and the next new thread reuses it
+ */
+struct TraceBuffer
+{
+    std::vector<TraceRecord> records = std::vector<TraceRecord>(TRACE_CAPACITY);
+    uint64_t written = 0; // Total pushed, the next slot is written % TRACE_CAPACITY
+    uint16_t lane = 0;
+    bool inUse = false;
+
+    // Context and counters the scopes snapshot
+    uint32_t game = 0;
+    uint8_t turn = 0;
+    uint64_t intersections = 0;
+    uint64_t tableBytes = 0;
+    TraceTotals totals[3];
+
+    inline void push(const TraceRecord &record)
+    {
+        records[written++ & (TRACE_CAPACITY - 1)] = record;
+        totals[(int)record.event].add(record);
+    }
+
+    inline void beginTurn(int currentTurn)
+    {
+        if (currentTurn == 1)
+            ++game;
+        turn = currentTurn;
+    }
+};
+
+struct TraceRegistry
+{
+    std::mutex lock;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+
+    // Calibrates cycles against wall time at flush
+    uint64_t startCycles = traceCycles();
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+};
+
+TraceRegistry &traceRegistry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+TraceBuffer &traceBuffer()
+{
+    // Claims an idle buffer for the lifetime of the thread
+    struct Claim
+    {
+        TraceBuffer *buffer;
+
+        Claim()
+        {
+            TraceRegistry &registry = traceRegistry();
+            std::lock_guard<std::mutex> guard(registry.lock);
+            for (auto &candidate : registry.buffers)
+            {
+                if (!candidate->inUse)
+                {
+                    buffer = candidate.get();
+                    buffer->inUse = true;
+                    return;
+                }
+            }
+            registry.buffers.push_back(std::make_unique<TraceBuffer>());
+            buffer = registry.buffers.back().get();
+            buffer->lane = registry.buffers.size() - 1;
+            buffer->inUse = true;
+        }
+
+        ~Claim()
+        {
+            std::lock_guard<std::mutex> guard(traceRegistry().lock);
+            buffer->inUse = false;
+        }
+    };
+
+    thread_local Claim claim;
+    return *claim.buffer;
+}
+
+/**
+ * Times its own lifetime and records it, with the counters added meanwhile.
+ *
+ * @param candidates Read when the scope ends
+ */
+struct TraceScope
+{
+    TraceBuffer &buffer;
+    TraceEvent event;
+    const std::vector<int> &candidates;
+    uint64_t intersections;
+    uint64_t tableBytes;
+    uint64_t start;
+
+    TraceScope(TraceEvent event, const std::vector<int> &candidates)
+        : buffer(traceBuffer()), event(event), candidates(candidates),
+          intersections(buffer.intersections), tableBytes(buffer.tableBytes), start(traceCycles()) {}
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+    ~TraceScope()
+    {
+        uint64_t cycles = traceCycles() - start;
+        buffer.push({start,
+                     (uint32_t)std::min<uint64_t>(cycles, UINT32_MAX),
+                     (uint32_t)candidates.size(),
+                     (uint32_t)(buffer.intersections - intersections),
+                     (uint32_t)std::min<uint64_t>(buffer.tableBytes - tableBytes, UINT32_MAX),
+                     buffer.game,
+                     buffer.lane,
+                     event,
+                     buffer.turn});
+    }
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(event, candidates) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(event, candidates)
+#define TRACE_TURN(turn) traceBuffer().beginTurn(turn)
+#define TRACE_COUNT(counter, n) (traceBuffer().counter += (n))
+
+// -------------------------------------------------------------------------------------------------
+//                                          Trace File
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Write every buffered record to path and print where the time went, then empty
+ * the buffers.
+ *
+ * @param path .csv for a text trace, anything else for TraceHeader + records
+ * @param report Where the summary goes
+ * @return false if the file cannot be written
+ * @warning Call while no other thread is recording
+ */
+bool flushTrace(const std::string &path, std::ostream &report)
+{
+    TraceRegistry &registry = traceRegistry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - registry.startTime).count();
+    double cyclesPerSecond = seconds > 0 ? (traceCycles() - registry.startCycles) / seconds : 1e9;
+
+    // Oldest first per lane
+    std::vector<TraceRecord> records;
+    uint64_t dropped = 0;
+    TraceTotals totals[3];
+    for (auto &buffer : registry.buffers)
+    {
+        uint64_t kept = std::min<uint64_t>(buffer->written, TRACE_CAPACITY);
+        dropped += buffer->written - kept;
+        for (uint64_t i = buffer->written - kept; i < buffer->written; ++i)
+            records.push_back(buffer->records[i & (TRACE_CAPACITY - 1)]);
+
+        for (int e = 0; e < 3; ++e)
+        {
+            TraceTotals &t = totals[e];
+            t.count += buffer->totals[e].count;
+            t.cycles += buffer->totals[e].cycles;
+            t.candidates += buffer->totals[e].candidates;
+            t.intersections += buffer->totals[e].intersections;
+            t.tableBytes += buffer->totals[e].tableBytes;
+            buffer->totals[e] = {};
+        }
+
+        buffer->written = 0;
+        buffer->game = 0;
+        buffer->intersections = 0;
+        buffer->tableBytes = 0;
+    }
+
+    bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    std::ofstream out(path, csv ? std::ios::trunc : std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "Could not write " << path << "\n";
+        return false;
+    }
+
+    static const char *EVENT_NAMES[] = {"turn", "filter", "algorithm"};
+    if (csv)
+    {
+        out << "lane,game,turn,event,start,cycles,ns,candidates,intersections,table_bytes\n";
+        for (const auto &r : records)
+            out << r.lane << "," << r.game << "," << (int)r.turn << "," << EVENT_NAMES[(int)r.event] << ","
+                << r.start << "," << r.cycles << "," << (uint64_t)(r.cycles * 1e9 / cyclesPerSecond) << ","
+                << r.candidates << "," << r.intersections << "," << r.tableBytes << "\n";
+    }
+    else
+    {
+        TraceHeader header = {};
+        std::memcpy(header.magic, "WRDLTRC", 8);
+        header.version = TRACE_VERSION;
+        header.recordSize = sizeof(TraceRecord);
+        header.cyclesPerSecond = cyclesPerSecond;
+        header.recordCount = records.size();
+        header.dropped = dropped;
+        out.write((const char *)&header, sizeof(header));
+        out.write((const char *)records.data(), records.size() * sizeof(TraceRecord));
+    }
+
+    // Where the time went, over every record since the last flush
+    uint64_t allCycles = 0;
+    for (const auto &t : totals)
+        allCycles += t.cycles;
+
+    report << "\nTrace: " << records.size() << " records (" << dropped << " overwritten) written to " << path << "\n";
+    report << "    Event    Calls   Total ms   Share %   Avg ns   Avg cand.   Intersect.   Table MB\n";
+    for (int e = 0; e < 3; ++e)
+    {
+        const TraceTotals &t = totals[e];
+        if (t.count == 0)
+            continue;
+
+        char line[128];
+        std::snprintf(line, sizeof(line), "%9s %8llu %10.1f %9.1f %8.0f %11.1f %12llu %10.1f\n",
+                      EVENT_NAMES[e], (unsigned long long)t.count, t.cycles * 1e3 / cyclesPerSecond,
+                      allCycles ? 100.0 * t.cycles / allCycles : 0.0, t.cycles * 1e9 / cyclesPerSecond / t.count,
+                      (double)t.candidates / t.count, (unsigned long long)t.intersections, t.tableBytes / 1e6);
+        report << line;
+    }
+    return (bool)out;
+}
+#else
+#define TRACE_SCOPE(event, candidates)
+#define TRACE_TURN(turn)
+#define TRACE_COUNT(counter, n)
+
+// Nothing to write unless built with TRACE_HOT_PATH
+bool flushTrace(const std::string &, std::ostream &)
+{
+    return false;
+}
+#endif
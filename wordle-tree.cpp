@@ -0,0 +1,257 @@
+#include "wordle-algorithms.cpp"
+
+#define TREE_URL "solve-tree.bin"
+#define TREE_VERSION 1
+
+struct TreeNode;
+struct TreeEdge;
+struct SolveTree;
+struct SolveTreeHeader;
+template <typename Algo>
+void buildSolveTree(const words &w, Algo algorithm, const std::string &firstGuess, SolveTree &tree);
+bool saveSolveTree(const words &w, const SolveTree &tree, const std::string &path);
+bool loadSolveTree(const words &w, SolveTree &tree, const std::string &path);
+std::vector<std::vector<int>> &patternBuckets(int turn);
+
+struct TreeNode
+{
+    uint32_t guess;     // Word index
+    uint32_t firstEdge; // Edges of a node are contiguous and sorted by pattern
+    uint32_t edgeCount;
+};
+
+struct TreeEdge
+{
+    uint32_t pattern;
+    uint32_t child;
+};
+
+/**
+ * Decision tree of a deterministic algorithm: node = guess to play,
+ * edge = observed pattern -> next node. Node 0 is the first guess.
+ *
+ * Replay looks children up in O(1): each node has a bitmap of the patterns it
+ * has edges for, and per bitmap word the edge count before it, so a child is
+ * its edge at rank + popcount of the lower bits.
+ */
+struct SolveTree
+{
+    static constexpr int MAP_WORDS = (PATTERN_COUNT + 63) / 64; // Bitmap words per node
+
+    std::vector<TreeNode> nodes;
+    std::vector<TreeEdge> edges;
+    std::vector<uint64_t> patternMap; // MAP_WORDS per node, bit p - an edge for pattern p
+    std::vector<uint16_t> edgeRank;   // MAP_WORDS per node, edges of the node before that word
+
+    inline uint32_t guess(int node) const
+    {
+        return nodes[node].guess;
+    }
+
+    /**
+     * Rebuild the lookup bitmaps, after the nodes and edges are filled.
+     */
+    void index()
+    {
+        patternMap.assign(nodes.size() * MAP_WORDS, 0);
+        edgeRank.assign(nodes.size() * MAP_WORDS, 0);
+        for (size_t node = 0; node < nodes.size(); ++node)
+        {
+            uint64_t *map = &patternMap[node * MAP_WORDS];
+            for (uint32_t e = 0; e < nodes[node].edgeCount; ++e)
+            {
+                uint32_t p = edges[nodes[node].firstEdge + e].pattern;
+                map[p >> 6] |= 1ull << (p & 63);
+            }
+
+            uint16_t rank = 0;
+            for (int i = 0; i < MAP_WORDS; ++i)
+            {
+                edgeRank[node * MAP_WORDS + i] = rank;
+                rank += __builtin_popcountll(map[i]);
+            }
+        }
+    }
+
+    /**
+     * @return Node to play after seeing pattern at node, -1 if no answer leads there
+     */
+    inline int next(int node, pattern_t pattern) const
+    {
+        const size_t word = node * MAP_WORDS + (pattern >> 6);
+        const uint64_t bit = 1ull << (pattern & 63);
+        if (!(patternMap[word] & bit))
+            return -1;
+
+        uint32_t rank = edgeRank[word] + __builtin_popcountll(patternMap[word] & (bit - 1));
+        return edges[nodes[node].firstEdge + rank].child;
+    }
+};
+
+struct SolveTreeHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t wordLen;
+    uint64_t dictHash;
+    uint64_t nodeCount;
+    uint64_t edgeCount;
+};
+
+// -------------------------------------------------------------------------------------------------
+//                                        Build Solve Tree
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Answers split by pattern at one recursion depth, on the heap and owned by the
+ * calling thread: at WORD_LEN 10 a set is 3^10 vectors, about 1.4 MB, too much
+ * for a thread stack once per level.
+ *
+ * @param turn Recursion depth, 1..MAX_TURNS
+ * @return PATTERN_COUNT empty buckets, capacity kept from earlier calls
+ */
+std::vector<std::vector<int>> &patternBuckets(int turn)
+{
+    thread_local std::vector<std::vector<std::vector<int>>> levels(MAX_TURNS + 1);
+    auto &buckets = levels[turn];
+    buckets.resize(PATTERN_COUNT);
+    for (auto &bucket : buckets)
+        bucket.clear();
+    return buckets;
+}
+
+/**
+ * Play every answer at once: split the answers reaching a node by the pattern its
+ * guess produces and ask the algorithm once per resulting state.
+ *
+ * @note Mirrors runAlgorithm turn for turn, so replaying gives the same results
+ */
+template <typename Algo>
+int buildSolveTreeNode(const words &w, Algo &algorithm, SolveTree &tree,
+                       const WordleState &state, const std::vector<int> &reach, uint32_t guess_idx, int turn)
+{
+    const int node = tree.nodes.size();
+    tree.nodes.push_back({guess_idx, 0, 0});
+
+    const std::string &guess = w.strings[guess_idx];
+    auto &buckets = patternBuckets(turn);
+    for (int word_idx : reach)
+        buckets[computePattern(w.chars(guess_idx), w.chars(word_idx))].push_back(word_idx);
+
+    std::vector<TreeEdge> children;
+    for (int p = 0; p < ALL_GREEN; ++p)
+    {
+        if (buckets[p].empty() || turn == MAX_TURNS)
+            continue;
+
+        // Any member gives the same feedback, hence the same state
+        WordleState next = state;
+        WordleGame game(w.strings[buckets[p][0]], &next);
+        game.currentTurn = turn;
+        game.turn(guess);
+        getCandidates(w, next);
+
+        uint32_t next_idx;
+        {
+            TRACE_SCOPE(TraceEvent::ALGORITHM, next.candidates);
+            next_idx = &algorithm(w, next) - w.strings.data();
+        }
+        int child = buildSolveTreeNode(w, algorithm, tree, next, buckets[p], next_idx, turn + 1);
+        children.push_back({(uint32_t)p, (uint32_t)child});
+    }
+
+    tree.nodes[node].firstEdge = tree.edges.size();
+    tree.nodes[node].edgeCount = children.size();
+    tree.edges.insert(tree.edges.end(), children.begin(), children.end());
+    return node;
+}
+
+/**
+ * Compile the full strategy of a deterministic algorithm over every answer.
+ */
+template <typename Algo>
+void buildSolveTree(const words &w, Algo algorithm, const std::string &firstGuess, SolveTree &tree)
+{
+    auto it = std::find(w.strings.begin(), w.strings.end(), firstGuess);
+    if (it == w.strings.end())
+    {
+        std::cerr << firstGuess << " is an invalid word!\n";
+        exit(1);
+    }
+
+    tree.nodes.clear();
+    tree.edges.clear();
+
+    WordleState state;
+    buildSolveTreeNode(w, algorithm, tree, state, w.answers, it - w.strings.begin(), 1);
+    tree.index();
+}
+
+// -------------------------------------------------------------------------------------------------
+//                                        Solve Tree File
+// -------------------------------------------------------------------------------------------------
+
+bool saveSolveTree(const words &w, const SolveTree &tree, const std::string &path)
+{
+    SolveTreeHeader header = {};
+    std::memcpy(header.magic, "WRDLTRE", 8);
+    header.version = TREE_VERSION;
+    header.wordLen = WORD_LEN;
+    header.dictHash = dictionaryHash(w);
+    header.nodeCount = tree.nodes.size();
+    header.edgeCount = tree.edges.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        return false;
+
+    out.write((const char *)&header, sizeof(header));
+    out.write((const char *)tree.nodes.data(), tree.nodes.size() * sizeof(TreeNode));
+    out.write((const char *)tree.edges.data(), tree.edges.size() * sizeof(TreeEdge));
+    return (bool)out;
+}
+
+/**
+ * @return false if the file is missing, corrupt or was built for another dictionary
+ */
+bool loadSolveTree(const words &w, SolveTree &tree, const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    SolveTreeHeader header;
+    if (!in.read((char *)&header, sizeof(header)))
+        return false;
+
+    if (std::memcmp(header.magic, "WRDLTRE", 8) != 0 ||
+        header.version != TREE_VERSION ||
+        header.wordLen != WORD_LEN ||
+        header.dictHash != dictionaryHash(w) ||
+        header.nodeCount == 0)
+        return false;
+
+    tree.nodes.resize(header.nodeCount);
+    tree.edges.resize(header.edgeCount);
+    in.read((char *)tree.nodes.data(), tree.nodes.size() * sizeof(TreeNode));
+    in.read((char *)tree.edges.data(), tree.edges.size() * sizeof(TreeEdge));
+    if (!in)
+        return false;
+
+    // Reject out of range references
+    for (const auto &node : tree.nodes)
+        if (node.guess >= w.strings.size() || (uint64_t)node.firstEdge + node.edgeCount > tree.edges.size())
+            return false;
+    for (const auto &edge : tree.edges)
+        if (edge.child >= tree.nodes.size() || edge.pattern >= PATTERN_COUNT)
+            return false;
+
+    // Lookups rank edges by pattern, so they must be strictly ascending per node
+    for (const auto &node : tree.nodes)
+        for (uint32_t e = 1; e < node.edgeCount; ++e)
+            if (tree.edges[node.firstEdge + e - 1].pattern >= tree.edges[node.firstEdge + e].pattern)
+                return false;
+
+    tree.index();
+    return true;
+}